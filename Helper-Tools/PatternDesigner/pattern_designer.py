@@ -62,6 +62,10 @@ class LEDFormat(Enum):
         
         return result
 
+    def is_packed(self) -> bool:
+        """RGB formats are stored packed, 3 bytes per LED (field 'rgb')."""
+        return self.value[3] is None
+
     @staticmethod
     def from_string(s: str) -> LEDFormat:
         """Parse format string like 'RGB', 'RGBW', etc."""
@@ -168,12 +172,22 @@ class PatternData:
     
     def to_bytes(self, led_format: LEDFormat) -> bytes:
         """Convert pattern to bytes using specified format."""
+        if led_format.is_packed():
+            return self.to_packed_bytes(led_format)
         data = bytearray()
         for r, g, b, w in self.leds:
             value = led_format.apply(r, g, b, w)
             data.extend(struct.pack('>I', value))  # Big-endian 32-bit
         return bytes(data)
 
+    def to_packed_bytes(self, led_format: LEDFormat) -> bytes:
+        """Convert pattern to 3 bytes per LED in the order they are sent."""
+        data = bytearray()
+        for r, g, b, w in self.leds:
+            value = led_format.apply(r, g, b, w)
+            data.extend(struct.pack('>I', value)[1:])
+        return bytes(data)
+
 
 class LEDVisualizer:
     """Handles visualization of LED strips."""
@@ -1005,8 +1019,9 @@ class PatternDesignerApp(tk.Tk):
         pattern_bytes = self.pattern.to_bytes(self.settings.led_format)
         pattern_b64 = base64.b64encode(pattern_bytes).decode('ascii')
         self._log_console(f"Pattern payload: {len(pattern_bytes)} bytes ({len(pattern_b64)} b64 chars)", tag="meta")
+        pattern_field = "rgb" if self.settings.led_format.is_packed() else "dat"
         self._run_logged_command(
-            [str(dfile_binary), "append", "dat", "-b64", pattern_b64, str(output_path)],
+            [str(dfile_binary), "append", pattern_field, "-b64", pattern_b64, str(output_path)],
             cwd=dfile_dir,
         )
 
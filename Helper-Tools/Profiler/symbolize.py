@@ -0,0 +1,221 @@
+#!/usr/bin/env python3
+"""
+Maps the output of the device command `profile dump` to functions.
+
+The addresses are looked up in the linker map that the firmware build writes
+next to the ELF (build/app/<name>.elf.map). The samples are summed per
+function and printed with their share of all samples, the hottest first.
+Use the map of the build that runs on the device, otherwise the names are
+wrong without any warning.
+
+Usage:
+  python symbolize.py dump.txt --map build/app/LEDController.elf.map
+  python symbolize.py --port /dev/ttyACM0 --map build/app/LEDController.elf.map --addresses
+"""
+
+from __future__ import annotations
+
+import argparse
+import bisect
+import re
+import shutil
+import subprocess
+import sys
+from dataclasses import dataclass, field
+from pathlib import Path
+
+SERIAL_BAUDRATE = 115200
+COMMAND_TERMINATOR = "\r\n"
+
+# Addresses below the flash are executed from the boot ROM (memcpy, float functions, ...)
+ROM_END = 0x10000000
+
+SECTION_LINE = re.compile(r"^ (\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*))?$")
+SECTION_CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*)$")
+SYMBOL_LINE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_][^=]*)$")
+
+
+@dataclass
+class Section:
+	name: str
+	start: int
+	size: int
+	object_file: str
+	symbols: list[tuple[int, str]] = field(default_factory=list)
+
+
+@dataclass
+class Profile:
+	rate: int = 0
+	core: int = 0
+	samples: int = 0
+	dropped: int = 0
+	counts: dict[int, int] = field(default_factory=dict)
+
+
+def read_dump_from_port(port: str, baudrate: int) -> list[str]:
+	import serial
+
+	with serial.Serial(port, baudrate, timeout=2.0) as device:
+		device.reset_input_buffer()
+		device.write(("profile dump" + COMMAND_TERMINATOR).encode("utf-8"))
+		lines = []
+		while True:
+			raw = device.readline()
+			if not raw:
+				raise RuntimeError("Timeout while reading the profile dump")
+			line = raw.decode("utf-8", errors="replace").strip()
+			lines.append(line)
+			if line == "end":
+				return lines
+
+
+def parse_dump(lines: list[str]) -> Profile:
+	profile = Profile()
+	started = False
+	for line in lines:
+		# the console prompt may precede the first line
+		if not started:
+			started = line.endswith("profile 1")
+			continue
+		parts = line.split()
+		if parts and parts[0] == "rate" and len(parts) == 8:
+			profile.rate, profile.core, profile.samples, profile.dropped = (int(parts[i]) for i in (1, 3, 5, 7))
+		elif parts and parts[0] == "pc" and len(parts) == 3:
+			pc = int(parts[1], 16)
+			profile.counts[pc] = profile.counts.get(pc, 0) + int(parts[2])
+		elif parts and parts[0] == "end":
+			break
+	if not started:
+		raise ValueError("No profile dump found (expected a line 'profile 1')")
+	return profile
+
+
+def parse_map(path: Path) -> list[Section]:
+	sections: list[Section] = []
+	pending: str | None = None
+	in_memory_map = False
+	for line in path.read_text(encoding="utf-8", errors="replace").splitlines():
+		if not in_memory_map:
+			in_memory_map = line.startswith("Linker script and memory map")
+			continue
+		if pending is not None:
+			# long section names are followed by the address on the next line
+			match = SECTION_CONTINUATION.match(line)
+			if match:
+				add_section(sections, pending, int(match.group(1), 16), int(match.group(2), 16), match.group(3))
+			pending = None
+			continue
+		match = SECTION_LINE.match(line)
+		if match:
+			if match.group(2) is None:
+				pending = match.group(1)
+			else:
+				add_section(sections, match.group(1), int(match.group(2), 16), int(match.group(3), 16), match.group(4))
+			continue
+		match = SYMBOL_LINE.match(line)
+		if match and sections:
+			address = int(match.group(1), 16)
+			name = match.group(2).strip()
+			section = sections[-1]
+			if section.start <= address < section.start + section.size and not name.startswith("PROVIDE"):
+				section.symbols.append((address, name))
+	sections.sort(key=lambda section: section.start)
+	return sections
+
+
+def add_section(sections: list[Section], name: str, start: int, size: int, object_file: str) -> None:
+	# only code and data sections that were placed into the image
+	if size == 0 or start == 0:
+		return
+	sections.append(Section(name, start, size, object_file.strip()))
+
+
+def section_function(section: Section) -> str:
+	# -ffunction-sections names the section after the function
+	for prefix in (".text.", ".time_critical."):
+		if section.name.startswith(prefix):
+			return section.name[len(prefix):]
+	return section.name
+
+
+class Symbolizer:
+	def __init__(self, sections: list[Section]):
+		self._sections = sections
+		self._starts = [section.start for section in sections]
+
+	def lookup(self, pc: int) -> tuple[str, str]:
+		"""Returns the function and the object file of the address"""
+		if pc < ROM_END:
+			return "[boot ROM]", ""
+		index = bisect.bisect_right(self._starts, pc) - 1
+		if index < 0 or pc >= self._sections[index].start + self._sections[index].size:
+			return f"[unknown 0x{pc:08x}]", ""
+		section = self._sections[index]
+		name = section_function(section)
+		for address, symbol in section.symbols:
+			if address <= pc:
+				name = symbol
+		return name, Path(section.object_file).name
+
+
+def demangle(names: list[str]) -> dict[str, str]:
+	mangled = [name for name in names if name.startswith("_Z")]
+	tool = shutil.which("arm-none-eabi-c++filt") or shutil.which("c++filt")
+	if not mangled or not tool:
+		return {}
+	result = subprocess.run([tool], input="\n".join(mangled), capture_output=True, text=True, check=False)
+	return dict(zip(mangled, result.stdout.splitlines()))
+
+
+def print_report(profile: Profile, symbolizer: Symbolizer, top: int, addresses: bool) -> None:
+	functions: dict[tuple[str, str], dict[int, int]] = {}
+	for pc, count in profile.counts.items():
+		functions.setdefault(symbolizer.lookup(pc), {})[pc] = count
+
+	names = demangle([name for name, _ in functions])
+	total = sum(profile.counts.values()) or 1
+	ranking = sorted(functions.items(), key=lambda item: sum(item[1].values()), reverse=True)
+
+	print(f"{total} samples at {profile.rate} Hz on core {profile.core}, {profile.dropped} dropped")
+	print(f"{'share':>7} {'samples':>8}  function")
+	for (name, object_file), pcs in ranking[:top]:
+		count = sum(pcs.values())
+		location = f"  ({object_file})" if object_file else ""
+		print(f"{100.0 * count / total:6.1f}% {count:8}  {names.get(name, name)}{location}")
+		if addresses:
+			for pc, pc_count in sorted(pcs.items(), key=lambda item: item[1], reverse=True):
+				print(f"{'':17}0x{pc:08x} {pc_count:8}")
+	if len(ranking) > top:
+		rest = sum(sum(pcs.values()) for _, pcs in ranking[top:])
+		print(f"{100.0 * rest / total:6.1f}% {rest:8}  ({len(ranking) - top} more functions)")
+
+
+def main() -> int:
+	parser = argparse.ArgumentParser(description="Map a `profile dump` of the LED controller to functions")
+	parser.add_argument("input", nargs="?", help="file with the captured output of `profile dump`")
+	parser.add_argument("--port", help="serial port of the device, runs `profile dump` itself")
+	parser.add_argument("--baud", type=int, default=SERIAL_BAUDRATE)
+	parser.add_argument("--map", required=True, help="linker map of the firmware (<name>.elf.map)")
+	parser.add_argument("--top", type=int, default=30, help="number of functions to print (default: 30)")
+	parser.add_argument("--addresses", action="store_true", help="list the sampled addresses per function")
+	args = parser.parse_args()
+
+	if args.port:
+		lines = read_dump_from_port(args.port, args.baud)
+	elif args.input:
+		lines = Path(args.input).read_text(encoding="utf-8", errors="replace").splitlines()
+	else:
+		parser.error("either an input file or --port is required")
+
+	profile = parse_dump([line.strip() for line in lines])
+	sections = parse_map(Path(args.map))
+	if not sections:
+		print(f"No sections found in {args.map}, is it a GNU ld map file?", file=sys.stderr)
+		return 1
+	print_report(profile, Symbolizer(sections), args.top, args.addresses)
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""
+Converts the output of the device command `trace dump` into Chrome trace JSON.
+
+Open the result in chrome://tracing (about:tracing) or https://ui.perfetto.dev.
+Every core is shown as a thread with the tasks as slices, flash operations are
+nested in the task that started them. Signals and interrupts are instant
+events, DMA transfers are async slices per channel.
+
+Usage:
+  python trace2chrome.py dump.txt -o trace.json       # captured console output
+  python trace2chrome.py --port /dev/ttyACM0 -o trace.json
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import struct
+import sys
+from dataclasses import dataclass
+from pathlib import Path
+
+SERIAL_BAUDRATE = 115200
+COMMAND_TERMINATOR = "\r\n"
+
+# Layout of Trace::Event, little endian
+EVENT_FORMAT = "<IIB3x"
+EVENT_SIZE = struct.calcsize(EVENT_FORMAT)
+
+TASK_START = 1
+TASK_END = 2
+SIGNAL = 3
+IRQ_ENTER = 4
+DMA_START = 5
+DMA_COMPLETE = 6
+FLASH_PROGRAM = 7
+FLASH_ERASE = 8
+FLASH_DONE = 9
+
+
+@dataclass
+class Event:
+	core: int
+	time: int
+	type: int
+	arg: int
+
+
+def read_dump_from_port(port: str, baudrate: int) -> list[str]:
+	import serial
+
+	with serial.Serial(port, baudrate, timeout=2.0) as device:
+		device.reset_input_buffer()
+		device.write(("trace dump" + COMMAND_TERMINATOR).encode("utf-8"))
+		lines = []
+		while True:
+			raw = device.readline()
+			if not raw:
+				raise RuntimeError("Timeout while reading the trace dump")
+			line = raw.decode("utf-8", errors="replace").strip()
+			lines.append(line)
+			if line == "end":
+				return lines
+
+
+def parse_dump(lines: list[str]) -> tuple[dict[int, str], list[Event], dict[int, int]]:
+	names: dict[int, str] = {}
+	events: list[Event] = []
+	overwritten: dict[int, int] = {}
+	core = -1
+	started = False
+	for line in lines:
+		# the console prompt may precede the first line
+		if not started:
+			started = line.endswith("trace 1")
+			continue
+		parts = line.split(" ", 2)
+		if parts[0] == "task" and len(parts) == 3:
+			names[int(parts[1])] = parts[2]
+		elif parts[0] == "core" and len(parts) == 3:
+			core = int(parts[1])
+			overwritten[core] = int(parts[2].split(" ")[1])
+		elif parts[0] == "ev" and len(parts) == 2:
+			data = bytes.fromhex(parts[1])
+			for offset in range(0, len(data) - EVENT_SIZE + 1, EVENT_SIZE):
+				time, arg, event_type = struct.unpack_from(EVENT_FORMAT, data, offset)
+				events.append(Event(core, time, event_type, arg))
+		elif parts[0] == "end":
+			break
+	if not started:
+		raise ValueError("No trace dump found (expected a line 'trace 1')")
+	return names, events, overwritten
+
+
+def unwrap_times(events: list[Event]) -> None:
+	# the timestamps are the lower 32 bits of the us timer, events of a core are in order
+	offsets: dict[int, int] = {}
+	last: dict[int, int] = {}
+	for event in events:
+		if event.time < last.get(event.core, 0):
+			offsets[event.core] = offsets.get(event.core, 0) + (1 << 32)
+		last[event.core] = event.time
+		event.time += offsets.get(event.core, 0)
+
+
+def signal_name(signal: int) -> str:
+	chars = signal.to_bytes(4, "big")
+	if all(0x21 <= c <= 0x7E for c in chars):
+		return chars.decode("ascii")
+	return f"0x{signal:08X}"
+
+
+def task_name(names: dict[int, str], pid: int) -> str:
+	return names.get(pid, f"task {pid}")
+
+
+def to_chrome(names: dict[int, str], events: list[Event]) -> dict:
+	trace = []
+	start = min((event.time for event in events), default=0)
+	depth: dict[int, int] = {}
+	cores = sorted({event.core for event in events})
+	for core in cores:
+		trace.append({"ph": "M", "name": "thread_name", "pid": 0, "tid": core, "args": {"name": f"core {core}"}})
+	trace.append({"ph": "M", "name": "process_name", "pid": 0, "args": {"name": "LED-Controller"}})
+
+	for event in events:
+		entry = {"pid": 0, "tid": event.core, "ts": event.time - start}
+		if event.type in (TASK_START, FLASH_PROGRAM, FLASH_ERASE):
+			if event.type == TASK_START:
+				entry.update(ph="B", name=task_name(names, event.arg), cat="task", args={"pid": event.arg})
+			else:
+				name = "flash program" if event.type == FLASH_PROGRAM else "flash erase"
+				entry.update(ph="B", name=name, cat="flash", args={"offset": f"0x{event.arg:08X}"})
+			depth[event.core] = depth.get(event.core, 0) + 1
+		elif event.type in (TASK_END, FLASH_DONE):
+			# the start may have been overwritten in the ring
+			if depth.get(event.core, 0) == 0:
+				continue
+			depth[event.core] -= 1
+			entry.update(ph="E")
+		elif event.type == SIGNAL:
+			entry.update(ph="i", s="t", name=f"signal {signal_name(event.arg)}", cat="signal")
+		elif event.type == IRQ_ENTER:
+			entry.update(ph="i", s="t", name=f"IRQ {event.arg}", cat="irq")
+		elif event.type in (DMA_START, DMA_COMPLETE):
+			entry.update(ph="b" if event.type == DMA_START else "e", name=f"DMA ch {event.arg}", cat="dma",
+						 id=event.arg)
+		else:
+			continue
+		trace.append(entry)
+	return {"traceEvents": trace, "displayTimeUnit": "ms"}
+
+
+def main() -> int:
+	parser = argparse.ArgumentParser(description="Convert a `trace dump` of the LED controller to Chrome trace JSON")
+	parser.add_argument("input", nargs="?", help="file with the captured output of `trace dump`")
+	parser.add_argument("--port", help="serial port of the device, runs `trace dump` itself")
+	parser.add_argument("--baud", type=int, default=SERIAL_BAUDRATE)
+	parser.add_argument("-o", "--output", default="trace.json", help="JSON file to write (default: trace.json)")
+	args = parser.parse_args()
+
+	if args.port:
+		lines = read_dump_from_port(args.port, args.baud)
+	elif args.input:
+		lines = Path(args.input).read_text(encoding="utf-8", errors="replace").splitlines()
+	else:
+		parser.error("either an input file or --port is required")
+
+	names, events, overwritten = parse_dump([line.strip() for line in lines])
+	unwrap_times(events)
+	Path(args.output).write_text(json.dumps(to_chrome(names, events)), encoding="utf-8")
+
+	for core, count in sorted(overwritten.items()):
+		if count:
+			print(f"core {core}: {count} older events were overwritten", file=sys.stderr)
+	print(f"{len(events)} events written to {args.output}")
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1 @@
+../../../../app/include/LED/BitPlane.h
\ No newline at end of file
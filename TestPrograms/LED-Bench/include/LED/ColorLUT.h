@@ -0,0 +1 @@
+../../../../app/include/LED/ColorLUT.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../app/include/LED/LEDFrame.h
\ No newline at end of file
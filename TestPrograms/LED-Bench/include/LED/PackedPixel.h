@@ -0,0 +1 @@
+../../../../app/include/LED/PackedPixel.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../app/include/LED/PowerLimiter.h
\ No newline at end of file
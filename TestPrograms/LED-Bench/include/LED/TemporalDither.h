@@ -0,0 +1 @@
+../../../../app/include/LED/TemporalDither.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../app/src/LED/ColorLUT.cpp
\ No newline at end of file
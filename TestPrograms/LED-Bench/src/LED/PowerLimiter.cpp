@@ -0,0 +1 @@
+../../../../app/src/LED/PowerLimiter.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../app/src/LED/TemporalDither.cpp
\ No newline at end of file
@@ -0,0 +1,272 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "LED/BitPlane.h"
+#include "LED/ColorLUT.h"
+#include "LED/LEDFrame.h"
+#include "LED/PowerLimiter.h"
+#include "LED/TemporalDither.h"
+
+// Measures the LED output stages on the host:
+//  - bit plane transposition for WS2812Parallel (BitPlane::transpose) against
+//    a bit by bit loop, for 4, 8 and 16 strips of 1000 LEDs, and from packed
+//    24 bit pixels (BitPlane::transposePacked)
+//  - gamma, brightness, white balance and color order (ColorLUT::apply)
+//    against the same math per channel in floating point; the host runs the
+//    table loop, the device looks the lanes up with the interpolators
+//  - temporal dithering (TemporalDither): setting a frame and rendering the
+//    8 bit frames, the average over 256 frames must match the 16 bit value
+//  - the power limiter (PowerLimiter): channel sum and scaling of a frame
+//    against a byte loop, a limited frame must stay within the budget
+// Every result is compared with the simple implementation first.
+
+using Clock = std::chrono::steady_clock;
+
+static const size_t LED_COUNT = 1000;
+static const unsigned BITS_PER_PIXEL = 24;
+static const int RUNS = 200;
+
+static double usPer(Clock::duration duration, int count) {
+  return std::chrono::duration<double, std::micro>(duration).count() / count;
+}
+
+static uint32_t randomPixel() { return (static_cast<uint32_t>(rand()) << 16) ^ static_cast<uint32_t>(rand()); }
+
+static void transposeBitwise(const uint32_t *const *strips, size_t stripCount, size_t ledCount, unsigned bitsPerPixel,
+                             uint8_t *out) {
+  const size_t width = BitPlane::planeWidth(stripCount);
+  memset(out, 0, BitPlane::frameSize(stripCount, ledCount, bitsPerPixel));
+  for (size_t led = 0; led < ledCount; led++) {
+    for (unsigned k = 0; k < bitsPerPixel; k++) {
+      for (size_t strip = 0; strip < stripCount; strip++) {
+        if (strips[strip][led] & (1u << (31 - k))) {
+          out[(led * bitsPerPixel + k) * width + strip / 8] |= 1u << (strip % 8);
+        }
+      }
+    }
+  }
+}
+
+template <typename Transpose>
+static double measure(Transpose transpose, const std::vector<const uint32_t *> &strips, std::vector<uint8_t> &out) {
+  auto start = Clock::now();
+  for (int run = 0; run < RUNS; run++) {
+    transpose(strips.data(), strips.size(), LED_COUNT, BITS_PER_PIXEL, out.data());
+  }
+  return usPer(Clock::now() - start, RUNS);
+}
+
+static bool benchTranspose() {
+  printf("Bit plane transposition, %zu LEDs per strip, %u bits per pixel (us per frame)\n", LED_COUNT,
+         BITS_PER_PIXEL);
+  printf("  strips  bitwise  transpose8x8  speedup  packed\n");
+  bool ok = true;
+  for (size_t stripCount : {4, 8, 16}) {
+    std::vector<std::vector<uint32_t>> frames(stripCount, std::vector<uint32_t>(LED_COUNT));
+    std::vector<std::vector<uint8_t>> packedFrames(stripCount, std::vector<uint8_t>(LED_COUNT * PackedPixel::BYTES));
+    std::vector<const uint32_t *> strips;
+    std::vector<const uint8_t *> packedStrips;
+    for (size_t s = 0; s < stripCount; s++) {
+      for (size_t led = 0; led < LED_COUNT; led++) {
+        frames[s][led] = randomPixel() & 0xFFFFFF00; // 24 bits are sent
+        PackedPixel::store(&packedFrames[s][led * PackedPixel::BYTES], frames[s][led]);
+      }
+      strips.push_back(frames[s].data());
+      packedStrips.push_back(packedFrames[s].data());
+    }
+    size_t size = BitPlane::frameSize(stripCount, LED_COUNT, BITS_PER_PIXEL);
+    std::vector<uint8_t> expected(size), actual(size);
+    transposeBitwise(strips.data(), stripCount, LED_COUNT, BITS_PER_PIXEL, expected.data());
+    BitPlane::transpose(strips.data(), stripCount, LED_COUNT, BITS_PER_PIXEL, actual.data());
+    std::vector<uint8_t> packed(size);
+    BitPlane::transposePacked(packedStrips.data(), stripCount, LED_COUNT, packed.data());
+    if (expected != actual || expected != packed) {
+      printf("  %6zu  MISMATCH\n", stripCount);
+      ok = false;
+      continue;
+    }
+
+    double bitwise = measure(transposeBitwise, strips, expected);
+    double fast = measure(
+        [](const uint32_t *const *strips, size_t stripCount, size_t ledCount, unsigned bitsPerPixel, uint8_t *out) {
+          BitPlane::transpose(strips, stripCount, ledCount, bitsPerPixel, out);
+        },
+        strips, actual);
+    auto start = Clock::now();
+    for (int run = 0; run < RUNS; run++) {
+      BitPlane::transposePacked(packedStrips.data(), stripCount, LED_COUNT, packed.data());
+    }
+    double fromPacked = usPer(Clock::now() - start, RUNS);
+    printf("  %6zu  %7.1f  %12.1f  %6.1fx  %6.1f\n", stripCount, bitwise, fast, bitwise / fast, fromPacked);
+  }
+  return ok;
+}
+
+// Per channel: (value / 255) ^ gamma * brightness * balance, then reordered
+static uint32_t colorReference(uint32_t pixel, uint8_t brightness, float gamma, uint32_t balance, const char *order) {
+  static const char channels[] = "RGBW";
+  uint32_t out = 0;
+  for (int lane = 0; lane < 4; lane++) {
+    unsigned shift = 24 - (strchr(channels, order[lane]) - channels) * 8;
+    float value = powf(((pixel >> shift) & 0xFF) / 255.0f, gamma);
+    float scale = brightness * static_cast<float>((balance >> shift) & 0xFF) / (255.0f * 255.0f);
+    out |= static_cast<uint32_t>(static_cast<uint8_t>(value * scale * 255.0f + 0.5f)) << (24 - lane * 8);
+  }
+  return out;
+}
+
+static bool benchColorLUT() {
+  const uint8_t brightness = 128;
+  const float gamma = 2.2f;
+  const uint32_t balance = 0xFFE0C0FF;
+  ColorLUT lut;
+  lut.setBrightness(brightness);
+  lut.setGamma(gamma);
+  lut.setBalance(balance);
+  lut.setOrder("GRB");
+
+  std::vector<uint32_t> in(LED_COUNT), expected(LED_COUNT), actual(LED_COUNT);
+  for (uint32_t &pixel : in) {
+    pixel = randomPixel();
+  }
+
+  auto start = Clock::now();
+  for (int run = 0; run < RUNS; run++) {
+    for (size_t i = 0; i < LED_COUNT; i++) {
+      expected[i] = colorReference(in[i], brightness, gamma, balance, lut.getOrder().c_str());
+    }
+  }
+  double reference = usPer(Clock::now() - start, RUNS);
+
+  start = Clock::now();
+  for (int run = 0; run < RUNS; run++) {
+    lut.apply(in.data(), actual.data(), LED_COUNT);
+  }
+  double table = usPer(Clock::now() - start, RUNS);
+
+  printf("Color LUT, %zu LEDs (us per frame)\n", LED_COUNT);
+  if (expected != actual) {
+    printf("  MISMATCH\n");
+    return false;
+  }
+  printf("  per channel  %6.1f\n  ColorLUT     %6.1f  %6.1fx\n", reference, table, reference / table);
+  return true;
+}
+
+static bool benchDither() {
+  ColorLUT lut;
+  lut.setBrightness(16); // night mode, where 8 bit steps are visible
+  lut.setGamma(2.2f);
+  printf("Temporal dithering, %zu LEDs (us per frame)\n", LED_COUNT);
+  printf("  lanes  set  render\n");
+  bool ok = true;
+  for (unsigned lanes : {3u, 4u}) {
+    const bool packed = lanes == 3;
+    TemporalDither dither(LED_COUNT, lanes, lut);
+    std::vector<uint32_t> in(LED_COUNT);
+    for (uint32_t &pixel : in) {
+      pixel = randomPixel();
+    }
+    std::vector<uint32_t> out(LED_COUNT); // large enough for both layouts
+
+    auto start = Clock::now();
+    for (int run = 0; run < RUNS; run++) {
+      dither.update();
+      for (size_t i = 0; i < LED_COUNT; i++) {
+        dither.set(i, in[i]);
+      }
+    }
+    double set = usPer(Clock::now() - start, RUNS);
+
+    // the errors carried over 256 frames cancel out: the 8 bit frames sum up to
+    // the 16 bit value (8 fractional bits)
+    std::vector<uint32_t> sums(LED_COUNT * lanes);
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(out.data());
+    for (int frame = 0; frame < 256; frame++) {
+      dither.render(reinterpret_cast<uint8_t *>(out.data()), packed);
+      for (size_t led = 0; led < LED_COUNT; led++) {
+        for (unsigned lane = 0; lane < lanes; lane++) {
+          sums[led * lanes + lane] += packed ? bytes[led * 3 + lane] : (out[led] >> (24 - lane * 8)) & 0xFF;
+        }
+      }
+    }
+    bool match = true;
+    for (size_t i = 0; i < sums.size() && match; i++) {
+      unsigned lane = i % lanes;
+      match = sums[i] == lut.map16(lane, (in[i / lanes] >> lut.getShift(lane)) & 0xFF);
+    }
+    if (!match) {
+      printf("  %5u  MISMATCH\n", lanes);
+      ok = false;
+      continue;
+    }
+
+    start = Clock::now();
+    for (int run = 0; run < RUNS; run++) {
+      dither.render(reinterpret_cast<uint8_t *>(out.data()), packed);
+    }
+    double render = usPer(Clock::now() - start, RUNS);
+    printf("  %5u  %4.1f  %6.1f\n", lanes, set, render);
+  }
+  return ok;
+}
+
+static bool benchPower() {
+  const size_t bytes = LED_COUNT * PackedPixel::BYTES;
+  std::vector<uint32_t> frame((bytes + 3) / 4); // word aligned like the frame buffers
+  uint8_t *data = reinterpret_cast<uint8_t *>(frame.data());
+  for (size_t i = 0; i < bytes; i++) {
+    data[i] = static_cast<uint8_t>(rand());
+  }
+  std::vector<uint8_t> original(data, data + bytes);
+
+  uint32_t reference = 0;
+  for (uint8_t value : original) {
+    reference += value;
+  }
+  bool ok = PowerLimiter::channelSum(data, bytes) == reference;
+
+  PowerLimiter::scale(data, bytes, 100);
+  for (size_t i = 0; i < bytes && ok; i++) {
+    ok = data[i] == ((original[i] * 100) >> 8);
+  }
+  if (!ok) {
+    printf("Power limiter MISMATCH\n");
+    return false;
+  }
+
+  // full white: 3 channels * 20 mA + 1 mA idle per LED
+  PowerLimiter power(5000);
+  memset(data, 0xFF, bytes);
+  power.limit(data, bytes, LED_COUNT);
+  PowerLimiter estimate;
+  estimate.limit(data, bytes, LED_COUNT);
+  if (power.getCurrent() != LED_COUNT * 61 || estimate.getCurrent() > power.getBudget()) {
+    printf("Power limiter: %u mA limited to %u mA, budget %u mA\n", power.getCurrent(), estimate.getCurrent(),
+           power.getBudget());
+    return false;
+  }
+
+  auto start = Clock::now();
+  for (int run = 0; run < RUNS; run++) {
+    memcpy(data, original.data(), bytes);
+    power.limit(data, bytes, LED_COUNT);
+  }
+  double limit = usPer(Clock::now() - start, RUNS);
+  printf("Power limiter, %zu LEDs (us per frame, with the copy of the frame)\n", LED_COUNT);
+  printf("  limit  %6.1f  (%u mA limited to %u mA)\n", limit, power.getCurrent(), power.getBudget());
+  return true;
+}
+
+int main() {
+  srand(1);
+  bool ok = benchTranspose();
+  ok = benchColorLUT() && ok;
+  ok = benchDither() && ok;
+  ok = benchPower() && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1 @@
+../../../app/include/Coroutine.h
\ No newline at end of file
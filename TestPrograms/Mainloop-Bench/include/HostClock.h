@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+// Virtual time source of the host build. time_us_64() returns the virtual
+// time, which only moves when the simulation advances it or when the Mainloop
+// waits for an event (the wait returns at its timeout immediately).
+class HostClock {
+public:
+  static uint64_t now() { return _now; }
+  static void advance(uint64_t us) { _now += us; }
+  // The time itself never goes back, the Mainloop keeps absolute deadlines
+  static void resetCounters() {
+    _waits = 0;
+    _idleTime = 0;
+  }
+
+  static bool waitUntil(uint64_t timeout) {
+    _waits++;
+    if (timeout > _now) {
+      _idleTime += timeout - _now;
+      _now = timeout;
+    }
+    return true;
+  }
+
+  // Number of idle waits and the virtual time spent in them
+  static uint32_t waits() { return _waits; }
+  static uint64_t idleTime() { return _idleTime; }
+
+private:
+  static inline uint64_t _now = 0;
+  static inline uint32_t _waits = 0;
+  static inline uint64_t _idleTime = 0;
+};
@@ -0,0 +1 @@
+../../../app/include/ITask.h
\ No newline at end of file
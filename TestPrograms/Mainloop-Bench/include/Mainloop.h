@@ -0,0 +1 @@
+../../../app/include/Mainloop.h
\ No newline at end of file
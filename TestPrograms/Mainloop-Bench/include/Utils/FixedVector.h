@@ -0,0 +1 @@
+../../../../app/include/Utils/FixedVector.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../app/include/Utils/FramePool.h
\ No newline at end of file
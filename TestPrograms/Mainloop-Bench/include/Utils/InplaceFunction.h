@@ -0,0 +1 @@
+../../../../app/include/Utils/InplaceFunction.h
\ No newline at end of file
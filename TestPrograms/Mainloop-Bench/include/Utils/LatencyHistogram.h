@@ -0,0 +1 @@
+../../../../app/include/Utils/LatencyHistogram.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../app/include/Utils/Signal.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../app/include/Utils/SignalIndex.h
\ No newline at end of file
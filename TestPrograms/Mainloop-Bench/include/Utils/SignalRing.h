@@ -0,0 +1 @@
+../../../../app/include/Utils/SignalRing.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../app/include/Utils/Trace.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../app/include/Utils/ValueConverter.h
\ No newline at end of file
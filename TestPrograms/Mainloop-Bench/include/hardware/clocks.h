@@ -0,0 +1,3 @@
+#pragma once
+
+// Host replacement, nothing used by the Mainloop
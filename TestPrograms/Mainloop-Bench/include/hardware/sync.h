@@ -0,0 +1,5 @@
+#pragma once
+
+// Host replacement, the interrupt functions are in pico/sync.h
+
+#include "pico/sync.h"
@@ -0,0 +1,5 @@
+#pragma once
+
+// Host replacement, core 1 is not simulated
+
+inline void multicore_launch_core1(void (*)(void)) {}
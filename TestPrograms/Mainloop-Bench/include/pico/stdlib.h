@@ -0,0 +1,22 @@
+#pragma once
+
+// Host replacement of the Pico SDK functions used by the Mainloop
+
+#include <cstdint>
+
+#include "HostClock.h"
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+inline uint64_t time_us_64() { return HostClock::now(); }
+inline uint32_t time_us_32() { return static_cast<uint32_t>(HostClock::now()); }
+inline absolute_time_t from_us_since_boot(uint64_t us) { return us; }
+inline bool best_effort_wfe_or_timeout(absolute_time_t timeout) { return HostClock::waitUntil(timeout); }
+
+// The simulation runs everything on core 0
+inline uint get_core_num() { return 0; }
+inline void tight_loop_contents() {}
+inline void busy_wait_us(uint64_t) {}
+// Thread mode, no exception is active
+inline uint __get_current_exception() { return 0; }
@@ -0,0 +1,16 @@
+#pragma once
+
+// Host replacement, the simulation is single threaded
+
+#include <cstdint>
+
+typedef struct {
+  bool locked;
+} critical_section_t;
+
+inline void critical_section_init(critical_section_t *section) { section->locked = false; }
+inline void critical_section_enter_blocking(critical_section_t *section) { section->locked = true; }
+inline void critical_section_exit(critical_section_t *section) { section->locked = false; }
+
+inline uint32_t save_and_disable_interrupts() { return 0; }
+inline void restore_interrupts(uint32_t) {}
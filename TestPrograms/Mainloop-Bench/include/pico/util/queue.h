@@ -0,0 +1,54 @@
+#pragma once
+
+// Host replacement of the Pico SDK queue (single threaded)
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+typedef struct {
+  std::vector<uint8_t> data;
+  unsigned int element_size;
+  unsigned int element_count;
+  unsigned int rptr;
+  unsigned int level;
+} queue_t;
+
+inline void queue_init(queue_t *q, unsigned int element_size, unsigned int element_count) {
+  q->data.assign(element_size * element_count, 0);
+  q->element_size = element_size;
+  q->element_count = element_count;
+  q->rptr = 0;
+  q->level = 0;
+}
+
+inline unsigned int queue_get_level(queue_t *q) { return q->level; }
+inline bool queue_is_empty(queue_t *q) { return q->level == 0; }
+
+inline bool queue_try_add(queue_t *q, const void *data) {
+  if (q->level == q->element_count) {
+    return false;
+  }
+  unsigned int wptr = (q->rptr + q->level) % q->element_count;
+  memcpy(&q->data[wptr * q->element_size], data, q->element_size);
+  q->level++;
+  return true;
+}
+
+inline bool queue_try_remove(queue_t *q, void *data) {
+  if (q->level == 0) {
+    return false;
+  }
+  memcpy(data, &q->data[q->rptr * q->element_size], q->element_size);
+  q->rptr = (q->rptr + 1) % q->element_count;
+  q->level--;
+  return true;
+}
+
+// Nobody else could empty the queue, so a full queue is a bug
+inline void queue_add_blocking(queue_t *q, const void *data) {
+  bool added = queue_try_add(q, data);
+  assert(added);
+  (void)added;
+}
@@ -0,0 +1 @@
+../../../app/src/Mainloop.cpp
\ No newline at end of file
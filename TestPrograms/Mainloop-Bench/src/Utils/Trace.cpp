@@ -0,0 +1 @@
+../../../../app/src/Utils/Trace.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../../../../app/src/Utils/ValueConverter.cpp
\ No newline at end of file
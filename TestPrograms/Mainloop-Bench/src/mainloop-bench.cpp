@@ -0,0 +1,438 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Coroutine.h"
+#include "HostClock.h"
+#include "Mainloop.h"
+#include "Utils/SignalIndex.h"
+#include "Utils/Trace.h"
+
+// Runs the Mainloop on the host with a virtual clock (HostClock.h) and
+// measures the scheduler overhead in real time:
+//  - dispatch cost of regular, timed and signal tasks
+//  - signal matching of the dispatch index against a linear scan of the filters
+//  - triggerSignal(), the part of the signal delivery that runs in interrupts
+//  - tick cost (getSysTick())
+//  - cost of recording a trace event (Trace::record())
+//  - idle behaviour: wakeups and load with only timed tasks
+//  - start lateness of a 1 ms timed task next to slow regular tasks, once with
+//    normal and once with low priority (time budget)
+//  - beep like sequences (steps of 1..8 ms) as regular tasks with sleepTask()
+//    and as coroutines with sleepMs()
+//  - executions of a 10 ms timed task with each overrun policy while a
+//    regular task blocks the core for 35 ms every 100 ms
+//  - check: a run once task (interval 0) stays run once when the timer queue
+//    is rebuilt, the bench fails otherwise
+//  - check: a coroutine waiting with waitSignal() is woken once per matching
+//    signal and not by others
+//  - check: 100 distinct signals, each triggered three times within one
+//    iteration, all reach their signal task
+// Every iteration advances the virtual clock by 1 ms.
+
+using Clock = std::chrono::steady_clock;
+
+static const int32_t intervals[] = {1, 5, 10, 30, 50, 100, 250, 1000};
+static const int intervalCount = sizeof(intervals) / sizeof(intervals[0]);
+
+static Mainloop &mainloop = Mainloop::getInstance();
+static std::vector<TaskPID> tasks;
+static volatile uint32_t executions;
+static uint32_t iterationCount;
+
+static double nsPer(Clock::duration duration, uint64_t count) {
+  return count == 0 ? 0 : std::chrono::duration<double, std::nano>(duration).count() / count;
+}
+
+// Removes all tasks of the previous run
+static void clearTasks() {
+  for (TaskPID pid : tasks) {
+    mainloop.killTask(pid);
+  }
+  tasks.clear();
+  TaskPID stopper = mainloop.registerRegularTask("stopper", [](TaskPID pid) {
+    mainloop.killTask(pid);
+    mainloop.stop();
+    return true;
+  });
+  (void)stopper;
+  mainloop.start();
+}
+
+// Runs the given number of iterations, the optional hook is called in every
+// iteration by a regular task
+template <typename Hook>
+static Clock::duration run(uint32_t iterations, Hook hook) {
+  uint32_t count = 0;
+  tasks.push_back(mainloop.registerRegularTask("driver", [&count, iterations, hook](TaskPID) {
+    HostClock::advance(1000);
+    hook(count);
+    if (++count >= iterations) {
+      mainloop.stop();
+    }
+    return true;
+  }));
+  executions = 0;
+  auto start = Clock::now();
+  mainloop.start();
+  auto duration = Clock::now() - start;
+  clearTasks();
+  return duration;
+}
+
+static Clock::duration run(uint32_t iterations) {
+  return run(iterations, [](uint32_t) {});
+}
+
+static bool countExecution(TaskPID) {
+  executions = executions + 1;
+  return true;
+}
+
+static void benchRegular(int taskCount, Clock::duration baseline) {
+  for (int i = 0; i < taskCount; i++) {
+    tasks.push_back(mainloop.registerRegularTask("regular", countExecution));
+  }
+  auto duration = run(iterationCount);
+  printf("  regular: %4d tasks  %8.1f ns/dispatch\n", taskCount, nsPer(duration - baseline, executions));
+}
+
+static void benchTimed(int taskCount, Clock::duration baseline) {
+  for (int i = 0; i < taskCount; i++) {
+    tasks.push_back(mainloop.registerTimedTask("timed", countExecution, intervals[i % intervalCount]));
+  }
+  auto duration = run(iterationCount);
+  uint32_t timedExecutions = executions;
+  printf("  timed:   %4d tasks  %8.1f ns/dispatch (%u executions)\n", taskCount,
+         nsPer(duration - baseline, timedExecutions), timedExecutions);
+}
+
+static void benchSignal(int taskCount, Clock::duration baseline) {
+  for (int i = 0; i < taskCount; i++) {
+    tasks.push_back(mainloop.registerSignalTask("signal", [](TaskPID) {
+      executions = executions + 1;
+      return false;
+    }, static_cast<Signal>(0x62656E00 + i)));
+  }
+  // one matching signal per iteration
+  auto duration = run(iterationCount, [taskCount](uint32_t count) {
+    mainloop.triggerSignal(static_cast<Signal>(0x62656E00 + count % taskCount));
+  });
+  printf("  signal:  %4d tasks  %8.1f ns/signal (trigger, match and dispatch, %u executions)\n", taskCount,
+         nsPer(duration - baseline, executions), executions);
+}
+
+// Exact filters plus a few wildcards, matched with the index of the Mainloop
+// and with a linear scan over all filters
+static void benchSignalIndex(int filterCount) {
+  const int wildcardCount = 4;
+  const uint32_t lookups = iterationCount * 16;
+  static SignalIndex<Mainloop::MAX_TASKS> index;
+  std::vector<SignalFilter> filters;
+  index.clear();
+  for (int i = 0; i < filterCount && i < static_cast<int>(Mainloop::MAX_TASKS); i++) {
+    SignalFilter filter = i < wildcardCount ? SignalFilter{0x67700000u + (i << 8), 0xFFFFFF00}
+                                            : SignalFilter{0x62656E00u + i, 0xFFFFFFFF};
+    filters.push_back(filter);
+    index.add(filter, i);
+  }
+
+  volatile uint32_t matches = 0;
+  auto start = Clock::now();
+  for (uint32_t i = 0; i < lookups; i++) {
+    index.match(0x62656E00u + i % filterCount, [&matches](uint16_t) { matches = matches + 1; });
+  }
+  auto indexTime = Clock::now() - start;
+  uint32_t indexMatches = matches;
+
+  matches = 0;
+  start = Clock::now();
+  for (uint32_t i = 0; i < lookups; i++) {
+    Signal signal = 0x62656E00u + i % filterCount;
+    for (const SignalFilter &filter : filters) {
+      if (((signal ^ filter.signal) & filter.mask) == 0) {
+        matches = matches + 1;
+      }
+    }
+  }
+  auto linearTime = Clock::now() - start;
+  printf("  signal match: %4d filters (%d wildcard)  index %6.1f ns, linear %6.1f ns (%u / %u matches)\n",
+         filterCount, wildcardCount, nsPer(indexTime, lookups), nsPer(linearTime, lookups), indexMatches, matches);
+}
+
+static void benchTrigger() {
+  const int signalsPerIteration = 16; // the pending ring holds 32
+  Clock::duration triggerTime{0};
+  run(iterationCount, [&triggerTime](uint32_t count) {
+    auto start = Clock::now();
+    for (int i = 0; i < signalsPerIteration; i++) {
+      mainloop.triggerSignal(static_cast<Signal>(count + i));
+    }
+    triggerTime += Clock::now() - start;
+  });
+  printf("  triggerSignal (interrupt side): %8.1f ns/call\n",
+         nsPer(triggerTime, static_cast<uint64_t>(iterationCount) * signalsPerIteration));
+
+  volatile uint32_t sum = 0;
+  auto start = Clock::now();
+  for (uint32_t i = 0; i < iterationCount * 16; i++) {
+    HostClock::advance(1);
+    sum = sum + mainloop.getSysTick();
+  }
+  printf("  tick (getSysTick):              %8.1f ns/call\n", nsPer(Clock::now() - start, iterationCount * 16));
+
+  start = Clock::now();
+  for (uint32_t i = 0; i < iterationCount * 16; i++) {
+    Trace::record(Trace::Type::Signal, i);
+  }
+  printf("  trace event (Trace::record):    %8.1f ns/call\n", nsPer(Clock::now() - start, iterationCount * 16));
+}
+
+static void benchIdle(int taskCount, bool verbose) {
+  const uint32_t durationMs = 10000;
+  HostClock::resetCounters();
+  for (int i = 0; i < taskCount; i++) {
+    tasks.push_back(mainloop.registerTimedTask("timed", [](TaskPID) {
+      HostClock::advance(20); // some work
+      executions = executions + 1;
+      return true;
+    }, intervals[i % intervalCount]));
+  }
+  tasks.push_back(mainloop.registerDelayedTask("stop", [](TaskPID) {
+    mainloop.stop();
+    return false;
+  }, durationMs));
+
+  executions = 0;
+  auto start = Clock::now();
+  mainloop.start();
+  auto duration = Clock::now() - start;
+  printf("  idle:    %4d tasks  %u ms simulated in %.1f ms, %u executions, %u idle waits, %.1f%% idle\n", taskCount,
+         durationMs, std::chrono::duration<double, std::milli>(duration).count(), executions, HostClock::waits(),
+         100.0 * HostClock::idleTime() / (durationMs * 1000.0));
+  if (verbose) {
+    mainloop.OuptutTaskInformation();
+  }
+  clearTasks();
+}
+
+// Slow regular tasks (300 us each) next to a 1 ms timed task that records
+// its start lateness
+static void benchPriority(int taskCount, Mainloop::Priority priority) {
+  const uint32_t durationMs = 1000;
+  for (int i = 0; i < taskCount; i++) {
+    TaskPID pid = mainloop.registerRegularTask("slow", [](TaskPID) {
+      HostClock::advance(300);
+      return true;
+    });
+    mainloop.setTaskPriority(pid, priority);
+    tasks.push_back(pid);
+  }
+  LatencyHistogram lateness;
+  uint64_t next = (HostClock::now() / 1000 + 1) * 1000;
+  tasks.push_back(mainloop.registerTimedTask("frame", [&lateness, &next](TaskPID) {
+    uint64_t now = HostClock::now();
+    lateness.add(now > next ? static_cast<uint32_t>(now - next) : 0);
+    next = (now / 1000 + 1) * 1000;
+    return true;
+  }, 1));
+  tasks.push_back(mainloop.registerDelayedTask("stop", [](TaskPID) {
+    mainloop.stop();
+    return false;
+  }, durationMs));
+  mainloop.start();
+  printf("  %s: %4d x 300 us tasks  1 ms task lateness p50 %u us, p99 %u us, max %u us\n",
+         priority == Mainloop::Priority::Low ? "low    " : "normal ", taskCount, lateness.percentile(50),
+         lateness.percentile(99), lateness.max());
+  clearTasks();
+}
+
+// Sequence of steps with short sleeps, once as a regular task that is polled
+// while it sleeps and once as a coroutine that is woken by the timer queue.
+// A busy task keeps the loop running (100 iterations per ms), so the sleeping
+// regular tasks are visited in every iteration.
+static Coroutine sequence() {
+  for (uint32_t step = 0;; step++) {
+    executions = executions + 1;
+    co_await Coroutine::sleepMs(1 + step % 8);
+  }
+}
+
+static void benchSequence(int sequenceCount, bool coroutines) {
+  const uint32_t durationMs = 1000;
+  std::vector<Coroutine> frames;
+  std::vector<uint32_t> steps(sequenceCount, 0);
+  for (int i = 0; i < sequenceCount; i++) {
+    if (coroutines) {
+      frames.push_back(sequence());
+      tasks.push_back(mainloop.registerCoroutine("sequence", frames.back()));
+    } else {
+      uint32_t *step = &steps[i];
+      tasks.push_back(mainloop.registerRegularTask("sequence", [step](TaskPID pid) {
+        executions = executions + 1;
+        mainloop.sleepTask(pid, 1 + (*step)++ % 8);
+        return true;
+      }));
+    }
+  }
+  tasks.push_back(mainloop.registerRegularTask("busy", [](TaskPID) {
+    HostClock::advance(10);
+    return true;
+  }));
+  tasks.push_back(mainloop.registerDelayedTask("stop", [](TaskPID) {
+    mainloop.stop();
+    return false;
+  }, durationMs));
+
+  executions = 0;
+  auto start = Clock::now();
+  mainloop.start();
+  auto duration = Clock::now() - start;
+  printf("  %s %4d sequences  %8.1f us per 1 ms (%u steps)\n", coroutines ? "coroutine:" : "regular:  ", sequenceCount,
+         std::chrono::duration<double, std::micro>(duration).count() / durationMs, executions);
+  clearTasks();
+}
+
+static void benchOverrun(Mainloop::OverrunPolicy policy, const char *name) {
+  const uint32_t durationMs = 1000;
+  uint32_t periods = 0;
+  executions = 0;
+  TaskPID pid = mainloop.registerTimedTask("frame", [&periods](TaskPID) {
+    executions = executions + 1;
+    periods += mainloop.getCoalescedPeriods();
+    return true;
+  }, 10);
+  mainloop.setOverrunPolicy(pid, policy);
+  tasks.push_back(pid);
+  tasks.push_back(mainloop.registerTimedTask("block", [](TaskPID) {
+    HostClock::advance(35000);
+    return true;
+  }, 100, 5));
+  tasks.push_back(mainloop.registerDelayedTask("stop", [](TaskPID) {
+    mainloop.stop();
+    return false;
+  }, durationMs));
+  mainloop.start();
+  printf("  %-9s %u ms, 10 ms task: %u executions, %u periods\n", name, durationMs, executions, periods);
+  clearTasks();
+}
+
+// Rescheduling a task in every iteration fills the timer queue with stale
+// entries until it is rebuilt from the pool
+static bool checkQueueRebuild() {
+  uint32_t runOnce = 0;
+  uint32_t parked = 0;
+  tasks.push_back(mainloop.registerTimedTask("once", [&runOnce](TaskPID) {
+    runOnce++;
+    return true;
+  }, 0));
+  TaskPID sleeper = mainloop.registerTimedTask("sleeper", [&parked](TaskPID) {
+    parked++;
+    return true;
+  }, Mainloop::ON_DEMAND, 1000000);
+  tasks.push_back(sleeper);
+  run(4 * Mainloop::MAX_TIMED_TASKS, [sleeper](uint32_t) { mainloop.sleepTask(sleeper, 1000000); });
+  bool ok = runOnce == 1 && parked == 0;
+  printf("  queue rebuild: run once task %u executions, sleeping task %u executions: %s\n", runOnce, parked,
+         ok ? "ok" : "FAILED");
+  return ok;
+}
+
+static Coroutine signalWaiter(uint32_t &wakeups) {
+  for (;;) {
+    co_await Coroutine::waitSignal(0x77616974);
+    wakeups++;
+  }
+}
+
+static bool checkSignalAwaiter() {
+  uint32_t wakeups = 0;
+  Coroutine waiter = signalWaiter(wakeups);
+  tasks.push_back(mainloop.registerCoroutine("waiter", waiter));
+  run(1000, [](uint32_t count) {
+    mainloop.triggerSignal(count % 10 == 0 ? 0x77616974 : 0x77616975);
+  });
+  bool ok = wakeups == 100;
+  printf("  waitSignal: %u wakeups for 100 signals: %s\n", wakeups, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// More distinct signals in one iteration than the old ring held, each
+// triggered several times
+static bool checkSignalBurst() {
+  const uint32_t signalCount = 100;
+  uint32_t matched = 0;
+  for (uint32_t i = 0; i < signalCount; i++) {
+    tasks.push_back(mainloop.registerSignalTask("burst", [&matched](TaskPID) {
+      matched++;
+      return false;
+    }, 0x62757200 + i));
+  }
+  run(2, [signalCount](uint32_t count) {
+    if (count == 0) {
+      for (uint32_t repeat = 0; repeat < 3; repeat++) {
+        for (uint32_t i = 0; i < signalCount; i++) {
+          mainloop.triggerSignal(0x62757200 + i);
+        }
+      }
+    }
+  });
+  bool ok = matched == signalCount;
+  printf("  signal burst: %u of %u signal tasks ran: %s\n", matched, signalCount, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  iterationCount = 20000;
+  bool verbose = false;
+  std::vector<int> taskCounts;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+      iterationCount = std::strtoul(argv[++i], nullptr, 0);
+    } else {
+      taskCounts.push_back(std::atoi(argv[i]));
+    }
+  }
+  if (taskCounts.empty()) {
+    taskCounts = {10, 50, 200};
+  }
+  printf("Usage: mainloop-bench [-v] [-i iterations] [task counts...]\n");
+  printf("%u iterations per run (1 iteration = 1 ms virtual time), at most %u tasks\n", iterationCount,
+         Mainloop::MAX_TASKS - 2);
+
+  Clock::duration baseline = run(iterationCount);
+  printf("  empty loop:       %8.1f ns/iteration\n", nsPer(baseline, iterationCount));
+
+  for (int taskCount : taskCounts) {
+    benchRegular(taskCount, baseline);
+    benchTimed(taskCount, baseline);
+    benchSignal(taskCount, baseline);
+  }
+  for (int taskCount : taskCounts) {
+    benchSignalIndex(taskCount);
+  }
+  benchTrigger();
+  for (int taskCount : taskCounts) {
+    benchIdle(taskCount, verbose);
+  }
+  for (int taskCount : taskCounts) {
+    benchPriority(taskCount, Mainloop::Priority::Normal);
+    benchPriority(taskCount, Mainloop::Priority::Low);
+  }
+  // limited by the coroutine frame pool
+  for (int sequenceCount : {4, 16, 32}) {
+    benchSequence(sequenceCount, false);
+    benchSequence(sequenceCount, true);
+  }
+  benchOverrun(Mainloop::OverrunPolicy::Skip, "skip:");
+  benchOverrun(Mainloop::OverrunPolicy::CatchUp, "catch up:");
+  benchOverrun(Mainloop::OverrunPolicy::Coalesce, "coalesce:");
+  bool ok = checkQueueRebuild();
+  ok = checkSignalAwaiter() && ok;
+  ok = checkSignalBurst() && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1 @@
+../../../../app/include/Utils/TimerQueue.h
\ No newline at end of file
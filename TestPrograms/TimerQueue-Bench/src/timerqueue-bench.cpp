@@ -0,0 +1,126 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Utils/TimerQueue.h"
+
+// Compares the per tick cost of the old Mainloop timed task handling (every
+// tick walks all tasks in the timer interrupt) with the TimerQueue based one
+// (the interrupt only counts, the mainloop pops the tasks that are due).
+//
+// The queue moves the work out of the interrupt, and the timing wheel in it
+// reschedules an execution in O(1), so the dispatch grows with the number of
+// executions instead of the number of tasks.
+
+struct LinearTask {
+  bool execute;
+  int32_t intervalMs;
+  uint32_t nextExecution;
+};
+
+struct QueueTask {
+  int32_t intervalMs;
+  uint32_t nextExecution;
+};
+
+static const int32_t intervals[] = {1, 5, 10, 30, 50, 100, 250, 1000};
+static const int intervalCount = sizeof(intervals) / sizeof(intervals[0]);
+
+static volatile uint32_t executions;
+
+static double nsPerTick(std::chrono::steady_clock::duration duration, uint32_t ticks) {
+  return std::chrono::duration<double, std::nano>(duration).count() / ticks;
+}
+
+static void benchLinear(int taskCount, uint32_t ticks) {
+  std::vector<LinearTask> tasks;
+  for (int i = 0; i < taskCount; i++) {
+    int32_t interval = intervals[i % intervalCount];
+    tasks.push_back({false, interval, static_cast<uint32_t>(interval)});
+  }
+
+  uint32_t systick = 0;
+  std::chrono::steady_clock::duration irqTime{0};
+  std::chrono::steady_clock::duration loopTime{0};
+  for (uint32_t t = 0; t < ticks; t++) {
+    auto start = std::chrono::steady_clock::now();
+    // old Mainloop::onMillisecond()
+    systick++;
+    for (auto &task : tasks) {
+      if (systick == task.nextExecution) {
+        task.execute = true;
+        task.nextExecution += task.intervalMs;
+      }
+    }
+    auto irqDone = std::chrono::steady_clock::now();
+    // old dispatch in Mainloop::start()
+    for (auto &task : tasks) {
+      if (task.execute) {
+        executions = executions + 1;
+        task.execute = false;
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    irqTime += irqDone - start;
+    loopTime += end - irqDone;
+  }
+
+  printf("  linear scan: %5d tasks  tick IRQ %9.1f ns/tick  dispatch %9.1f ns/tick  total %9.1f ns/tick\n", taskCount,
+         nsPerTick(irqTime, ticks), nsPerTick(loopTime, ticks), nsPerTick(irqTime + loopTime, ticks));
+}
+
+static void benchQueue(int taskCount, uint32_t ticks) {
+  std::vector<QueueTask> tasks;
+  TimerQueue queue;
+  for (int i = 0; i < taskCount; i++) {
+    int32_t interval = intervals[i % intervalCount];
+    tasks.push_back({interval, static_cast<uint32_t>(interval)});
+    queue.push(tasks.back().nextExecution, i);
+  }
+
+  volatile uint32_t systick = 0;
+  std::chrono::steady_clock::duration irqTime{0};
+  std::chrono::steady_clock::duration loopTime{0};
+  for (uint32_t t = 0; t < ticks; t++) {
+    auto start = std::chrono::steady_clock::now();
+    // new Mainloop::onMillisecond()
+    systick = systick + 1;
+    auto irqDone = std::chrono::steady_clock::now();
+    // new Mainloop::executeTimedTasks()
+    uint32_t now = systick;
+    while (queue.isDue(now)) {
+      TimerQueue::Entry entry = queue.top();
+      auto &task = tasks[entry.id];
+      if (task.nextExecution != entry.deadline) {
+        queue.pop();
+        continue;
+      }
+      task.nextExecution += task.intervalMs;
+      queue.replaceTop(task.nextExecution, entry.id);
+      executions = executions + 1;
+    }
+    auto end = std::chrono::steady_clock::now();
+    irqTime += irqDone - start;
+    loopTime += end - irqDone;
+  }
+
+  printf("  timer queue: %5d tasks  tick IRQ %9.1f ns/tick  dispatch %9.1f ns/tick  total %9.1f ns/tick\n", taskCount,
+         nsPerTick(irqTime, ticks), nsPerTick(loopTime, ticks), nsPerTick(irqTime + loopTime, ticks));
+}
+
+int main(int argc, char **argv) {
+  uint32_t ticks = 100000;
+  if (argc > 1) {
+    ticks = std::strtoul(argv[1], nullptr, 0);
+  }
+  printf("Usage: timerqueue-bench [ticks]\n");
+  printf("Simulating %u ticks (1 tick = 1 ms), task intervals 1..1000 ms\n", ticks);
+
+  const int taskCounts[] = {10, 100, 1000};
+  for (int taskCount : taskCounts) {
+    benchLinear(taskCount, ticks);
+    benchQueue(taskCount, ticks);
+  }
+  return 0;
+}
@@ -2,19 +2,22 @@
 
 #include "ICommand.h"
 #include "Mainloop.h"
-#include "ITask.h"
+#include "Coroutine.h"
 #include "deviceController/DeviceRepository.h"
 #include "devices/PWMDevice.h"
 #include <iomanip>
 #include <iostream>
 
 
-class BeepCommandTaskBase : public ITask {
+// Plays a sequence of beeps as a coroutine, the task only wakes up when the
+// next beep is due
+class BeepCommandTaskBase {
 public:
   BeepCommandTaskBase(std::shared_ptr<PWMDevice> device, Mainloop& mainloop)
     : _device(device), _mainloop(mainloop) {}
+  virtual ~BeepCommandTaskBase() = default;
 
-  const std::string getName() const override {
+  const std::string getName() const {
     return "BeepCommandTask - " + _device->getName();
   }
 
@@ -26,26 +29,43 @@ public:
     return _device->getName();
   }
 
-  virtual bool isFinished() const = 0;
+  // Returns INVALID_PID when no coroutine frame is free
+  TaskPID start() {
+    _coroutine = play();
+    TaskPID pid = _mainloop.registerCoroutine(getName(), _coroutine);
+    _finished = (pid == Mainloop::INVALID_PID);
+    return pid;
+  }
+
+  bool isFinished() const {
+    return _finished;
+  }
 
 protected:
   std::shared_ptr<PWMDevice> _device;
   Mainloop& _mainloop;
 
-  size_t _current_index = 0;
   bool _looping = false;
-
-  bool setBeep(TaskPID pid, uint16_t frequency, uint16_t duration) {
-    if (frequency <= 0) {
-      _device->setLevel(0);
-    } else {
-      _device->configurePWM(frequency);
-    }
-
-    if(duration > 0) {
-      _mainloop.sleepTask(pid, duration);
-    }
-    return true;
+  bool _finished = false;
+  Coroutine _coroutine;
+
+  virtual size_t getBeepCount() const = 0;
+  virtual std::pair<uint16_t, uint16_t> getBeep(size_t index) const = 0;
+
+  Coroutine play() {
+    do {
+      for (size_t i = 0; i < getBeepCount(); i++) {
+        const auto [frequency, duration] = getBeep(i);
+        if (frequency <= 0) {
+          _device->setLevel(0);
+        } else {
+          _device->configurePWM(frequency);
+        }
+        co_await Coroutine::sleepMs(duration);
+      }
+    } while (_looping);
+    _device->setLevel(0);
+    _finished = true;
   }
 };
 
@@ -54,29 +74,13 @@ public:
   BeepCommandFileTask(std::shared_ptr<PWMDevice> device, Mainloop& mainloop, const uint16_t* data, size_t count)
     : BeepCommandTaskBase(device, mainloop), _data_ptr(data), _data_count(count) {}
 
-  bool ExecuteTask(TaskPID pid) override {
-    if (isFinished()) {
-      _device->setLevel(0);
-      _mainloop.killTask(pid); // Remove the task from the mainloop when finished
-      return false; // No more beeps to play, task is finished
-    }
-
-    const uint16_t frequency = _data_ptr[_current_index * 2];
-    const uint16_t duration = _data_ptr[_current_index * 2 + 1];
-
-    _current_index++;
-    if(_looping && _current_index >= _data_count) {
-      _current_index = 0;
-    }
-
-    return setBeep(pid, frequency, duration);
+protected:
+  size_t getBeepCount() const override {
+    return _data_count;
   }
 
-  bool isFinished() const override {
-    if(_looping) {
-      return false;
-    }
-    return _current_index >= _data_count;
+  std::pair<uint16_t, uint16_t> getBeep(size_t index) const override {
+    return {_data_ptr[index * 2], _data_ptr[index * 2 + 1]};
   }
 
 private:
@@ -89,32 +93,17 @@ public:
   BeepCommandTask(std::shared_ptr<PWMDevice> device, Mainloop& mainloop)
     : BeepCommandTaskBase(device, mainloop) {}
 
-  bool ExecuteTask(TaskPID pid) override {
-    if (isFinished()) {
-      _device->setLevel(0);
-      _mainloop.killTask(pid); // Remove the task from the mainloop when finished
-      return false; // No more beeps to play, task is finished
-    }
-    
-    const auto& [frequency, duration] = _beep_sequence[_current_index];
-
-    _current_index++;
-    if(_looping && _current_index >= _beep_sequence.size()) {
-      _current_index = 0;
-    }
-
-    return setBeep(pid, frequency, duration);
-  }
-
   void addBeep(uint16_t frequency, uint16_t duration) {
     _beep_sequence.emplace_back(frequency, duration);
   }
 
-  bool isFinished() const override {
-    if(_looping) {
-      return false;
-    }
-    return _current_index >= _beep_sequence.size();
+protected:
+  size_t getBeepCount() const override {
+    return _beep_sequence.size();
+  }
+
+  std::pair<uint16_t, uint16_t> getBeep(size_t index) const override {
+    return _beep_sequence[index];
   }
 
 private:
@@ -187,8 +176,11 @@ public:
       task->addBeep(static_cast<uint16_t>(frequency), static_cast<uint16_t>(duration));
     }
 
+    if (task->start() == Mainloop::INVALID_PID) {
+      std::cout << "No free task for the beep sequence" << std::endl;
+      return -1;
+    }
     _activeTasks.push_back(task);
-    _mainloop.registerRegularTask(task.get());
 
     return 0; // Return 0 to indicate success
   }
@@ -222,8 +214,11 @@ private:
 
     auto task = std::make_shared<BeepCommandFileTask>(device, _mainloop, data, data_size / (2 * sizeof(uint16_t)));
     task->setLooping(loop);
+    if (task->start() == Mainloop::INVALID_PID) {
+      std::cout << "No free task for the beep sequence" << std::endl;
+      return -1;
+    }
     _activeTasks.push_back(task);
-    _mainloop.registerRegularTask(task.get());
 
     return 0;
   }
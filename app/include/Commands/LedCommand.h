@@ -4,21 +4,42 @@
 #include "Mainloop.h"
 #include "ITask.h"
 #include "Console.h"
+#include "Config.h"
 #include "deviceController/DeviceRepository.h"
-#include "devices/WS2812.h"
+#include "deviceController/Helper/LEDStripHelper.h"
+#include "devices/PacedPlayback.h"
+#include "LED/LEDFrame.h"
 #include "Utils/dataFile.h"
 #include <string>
 #include <cstdint>
 
 class LedCommandTask : public ITask {
 public:
-  LedCommandTask(std::shared_ptr<WS2812> device, const uint32_t* pattern_data, size_t pattern_size, int offsetjump, bool loop = false)
-    : _device(device), _pattern_data(pattern_data), _pattern_size(pattern_size), _offsetjump(offsetjump), _loop(loop) {}
+  // pattern_data holds pattern_size pixels, packed (3 bytes each) or as uint32_t
+  // The task runs on the render core, its messages are printed by the console Mainloop
+  LedCommandTask(Mainloop &console, std::shared_ptr<ILEDStrip> device, const void* pattern_data, size_t pattern_size, bool packed, int offsetjump, bool loop = false)
+    : _console(console), _device(device), _pattern_data(pattern_data), _pattern_size(pattern_size), _packed(packed), _offsetjump(offsetjump), _loop(loop) {}
 
   bool ExecuteTask(TaskPID pid) override {
-    if(!_device->setPattern(&_pattern_data[_current_offset], _device->getLEDCount())) { // Assuming each LED pattern is 4 bytes (e.g., RGB or RGBW)
+    if(!_is_playing) {
+      return false; // stopped, waiting for the removal
+    }
+    // frames that were due while the core or the strip was busy are skipped,
+    // so the playback keeps its speed on long strips
+    uint32_t frames = _device->getFrameGovernor().admit(Mainloop::getInstance().getCoalescedPeriods(), _device->isFramePending());
+    if(frames == 0) {
+      return true; // the strip did not take the previous frame yet
+    }
+    for(uint32_t i = 1; i < frames && hasNextFrame(); i++) {
+      _current_offset += _offsetjump;
+      if(_loop && _pattern_size - _current_offset < _device->getLEDCount()) {
+        _current_offset = 0;
+      }
+    }
+
+    if(!showFrame(*_device, _pattern_data, _packed, _current_offset)) {
       _is_playing = false;
-      std::cout << "Failed to set LED pattern for device: " << _device->getName() << std::endl;
+      report("Failed to set LED pattern for device: " + _device->getName());
       return false;
     }
 
@@ -28,7 +49,7 @@ public:
       if(_loop) {
         _current_offset = 0;
       } else {
-        std::cout << "Finished playing LED pattern on device: " << _device->getName() << std::endl;
+        report("Finished playing LED pattern on device: " + _device->getName());
       }
     }
     
@@ -39,6 +60,14 @@ public:
     return "LedPlayTask - " + _device->getName();
   }
 
+  // Sets the frame starting at pixel offset of the pattern
+  static bool showFrame(ILEDStrip& device, const void* pattern_data, bool packed, size_t offset) {
+    if(packed) {
+      return device.setPackedPattern(static_cast<const uint8_t*>(pattern_data) + offset * PackedPixel::BYTES, device.getLEDCount());
+    }
+    return device.setPattern(static_cast<const uint32_t*>(pattern_data) + offset, device.getLEDCount());
+  }
+
   const std::string getDeviceName() const {
     return _device->getName();
   }
@@ -60,14 +89,34 @@ public:
     _is_playing = false;
   }
 
+  bool hasNextFrame() const {
+    return _loop || _current_offset + _offsetjump + _device->getLEDCount() <= _pattern_size;
+  }
+
+  void setPID(TaskPID pid) {
+    _pid = pid;
+  }
+
+  TaskPID getPID() const {
+    return _pid;
+  }
+
 private:
-  std::shared_ptr<WS2812> _device;
-  const uint32_t* _pattern_data;
+  Mainloop &_console;
+  std::shared_ptr<ILEDStrip> _device;
+  const void* _pattern_data;
   size_t _pattern_size;
+  bool _packed;
   int _offsetjump;
   bool _loop;
   int _current_offset = 0;
-  bool _is_playing = true;
+  volatile bool _is_playing = true; // cleared by stop() on the console core
+  TaskPID _pid = -1;
+
+  // Hands the message to the console core, so it does not interleave with its output
+  void report(const std::string &message) const {
+    _console.invoke([message]() { std::cout << message << std::endl; });
+  }
 };
 
 class LedCommand : public ICommand {
@@ -84,8 +133,16 @@ public:
     return "Usage: led <deviceName> show <filename> [<offset>]\n"
            "       led <deviceName> play <filename> [<speed>]\n"
            "       led <deviceName> loop <filename> [<speed>]\n"
+           "       led <deviceName> pace <filename> [<period_us>]\n"
+           "       led <deviceName> paceloop <filename> [<period_us>]\n"
            "       led <deviceName> stop\n\n"
-           "       Displays the contents of the specified file on the LED device.";
+           "       Displays the contents of the specified file on the LED device (WS2812 or WS2812P,\n"
+           "       the frames of a WS2812P device hold its strips one after the other). The pixels\n"
+           "       are uint32_t (field dat) or packed, 3 bytes per LED in the order they are sent (rgb).\n"
+           "       pace and paceloop play on a WS2812 device, paced by a hardware alarm: the frames are\n"
+           "       sent straight from the file without jitter. The pixels have to be in the format of\n"
+           "       the strip (rgb for 24 bits per pixel, dat for 32) and its LUT has to be the identity.\n"
+           "       paceloop continues a frame that runs over the end of the pattern at its start (DMA).";
   }
 
   // Executes the command
@@ -97,13 +154,21 @@ public:
         ++it;
       }
     }
+    for (auto it = _pacedPlaybacks.begin(); it != _pacedPlaybacks.end();) {
+      if ((*it)->isFinished()) {
+        it = _pacedPlaybacks.erase(it);
+      } else {
+        ++it;
+      }
+    }
 
     if (args.size() < 3) {
       std::cout << getHelp() << std::endl;
       return -1; // Return -1 to indicate failure
     }
 
-    auto device = _deviceRepo.getDevice<WS2812>("WS2812", args[1]);
+    // a frame of a parallel device holds all of its strips one after the other
+    std::shared_ptr<ILEDStrip> device = LEDStripHelper::findLEDStrip(args[1], _deviceRepo);
     if (!device) {
       std::cout << "Device not found: " << args[1] << std::endl;
       return -1; // Return -1 to indicate failure
@@ -128,15 +193,18 @@ public:
     }
 
     if (args[2] == "show") {
-      const uint32_t* pattern_data = nullptr;
+      const void* pattern_data = nullptr;
       size_t pattern_size = 0;
+      bool packed = false;
       int offset = parameter;
 
       auto current = reader->start();
       while(current != nullptr && pattern_size == 0 && current != reader->end()) {
-        if(reader->getFieldSignature(current) == 0xA470 /*dat*/) {
-          pattern_size = reader->getDataSize(current) / 4; // Assuming each LED pattern is 4 bytes (e.g., RGB or RGBW)
-          pattern_data = (const uint32_t*)reader->getFieldData(current);
+        if(reader->getFieldSignature(current) == 0xA470 /*dat*/ || reader->getFieldSignature(current) == 0x2B59 /*rgb*/) {
+          // one uint32_t per LED, or packed: 3 bytes per LED
+          packed = reader->getFieldSignature(current) == 0x2B59;
+          pattern_size = reader->getDataSize(current) / (packed ? PackedPixel::BYTES : 4);
+          pattern_data = reader->getFieldData(current);
         }else if(reader->getFieldSignature(current) == 0xAF96 /*jmp*/){
           const uint16_t* jump_data = reinterpret_cast<const uint16_t*>(reader->getFieldData(current));
           offset *= *jump_data;
@@ -149,22 +217,25 @@ public:
         return -1; // Return -1 to indicate failure
       }
       
-      if(!device->setPattern(&pattern_data[offset], device->getLEDCount())) { // Assuming each LED pattern is 4 bytes (e.g., RGB or RGBW)
+      if(!LedCommandTask::showFrame(*device, pattern_data, packed, offset)) {
         std::cout << "Failed to set LED pattern." << std::endl;
         return -1; // Return -1 to indicate failure
       }
       return 0; // Return 0 to indicate success
-    } else if (args[2] == "play" || args[2] == "loop") {
-      const uint32_t* pattern_data = nullptr;
+    } else if (args[2] == "play" || args[2] == "loop" || args[2] == "pace" || args[2] == "paceloop") {
+      const void* pattern_data = nullptr;
       size_t pattern_size = 0;
+      bool packed = false;
       int speed = 0;
       int offset_jump = 0;
 
       auto current = reader->start();
       while(current != nullptr && pattern_size == 0 && current != reader->end()) {
-        if(reader->getFieldSignature(current) == 0xA470 /*dat*/) {
-          pattern_size = reader->getDataSize(current) / 4; // Assuming each LED pattern is 4 bytes (e.g., RGB or RGBW)
-          pattern_data = (const uint32_t*)reader->getFieldData(current);
+        if(reader->getFieldSignature(current) == 0xA470 /*dat*/ || reader->getFieldSignature(current) == 0x2B59 /*rgb*/) {
+          // one uint32_t per LED, or packed: 3 bytes per LED
+          packed = reader->getFieldSignature(current) == 0x2B59;
+          pattern_size = reader->getDataSize(current) / (packed ? PackedPixel::BYTES : 4);
+          pattern_data = reader->getFieldData(current);
         }else if(reader->getFieldSignature(current) == 0x40DC /*tim*/){
           const uint16_t* timing_data = reinterpret_cast<const uint16_t*>(reader->getFieldData(current));
           speed = *timing_data;
@@ -175,24 +246,50 @@ public:
         current = reader->next(current);
       }
 
+      if (args[2] == "pace" || args[2] == "paceloop") {
+        // the period is given in microseconds
+        uint32_t period_us = parameter > 0 ? parameter : speed * 1000;
+        return pace(args[1], pattern_data, pattern_size, packed, offset_jump, period_us, args[2] == "paceloop");
+      }
+
       if(parameter > 0) {
         speed = parameter;
       }
 
       bool loop = (args[2] == "loop");
+      if(static_cast<uint32_t>(speed) * 1000 < device->getFrameGovernor().getFrameTimeUs()) {
+        std::cout << "The strip takes at most " << device->getFrameGovernor().getMaxFrameRate()
+                  << " frames per second, frames in between are skipped." << std::endl;
+      }
 
-      auto task = std::make_unique<LedCommandTask>(device, pattern_data, pattern_size, offset_jump, loop);
-      _mainloop.registerTimedTask(task.get(), speed);
+      // the registered function shares the task, it is freed once the render
+      // core removed it, not when it leaves _signalTasks
+      auto task = std::make_shared<LedCommandTask>(_mainloop, device, pattern_data, pattern_size, packed, offset_jump, loop);
+      task->setPID(_mainloop.registerTimedTask(task->getName(), [task](TaskPID pid) { return task->ExecuteTask(pid); },
+                                               speed, 0, LED_RENDER_CORE));
+      if(task->getPID() == Mainloop::INVALID_PID) {
+        std::cout << "No free timed task on the render core, stop a playback first." << std::endl;
+        return -1;
+      }
+      _mainloop.setOverrunPolicy(task->getPID(), Mainloop::OverrunPolicy::Coalesce);
       _signalTasks.push_back(std::move(task));
 
       return 0;
     } else if (args[2] == "stop") {
       for (auto it = _signalTasks.begin(); it != _signalTasks.end();) {
         if ((*it)->getDeviceName() == device->getName()) {
+          // the kill is queued for the render core, the task stops itself in
+          // case it runs before that
           (*it)->stop();
+          _mainloop.killTask((*it)->getPID());
         }
         ++it;
       }
+      for (auto& playback : _pacedPlaybacks) {
+        if (playback->getDeviceName() == device->getName()) {
+          playback->stop();
+        }
+      }
       return 0;
     }
     std::cout << "Invalid action: " << args[2] << std::endl;
@@ -205,5 +302,31 @@ private:
   const Console &_console; // Reference to the console object
   DeviceRepository &_deviceRepo; // Reference to the device repository
 
-  std::vector<std::unique_ptr<LedCommandTask>> _signalTasks; // Store active signal tasks for management
+  std::vector<std::shared_ptr<LedCommandTask>> _signalTasks; // Store active signal tasks for management
+  std::vector<std::unique_ptr<PacedPlayback>> _pacedPlaybacks;
+
+  int pace(const std::string& name, const void* pattern_data, size_t pattern_size, bool packed, int offset_jump,
+           uint32_t period_us, bool loop) {
+    auto strip = _deviceRepo.getDevice<WS2812>("WS2812", name);
+    if (!strip) {
+      std::cout << "pace needs a WS2812 device: " << name << std::endl;
+      return -1;
+    }
+    if (!strip->canSendDirect(pattern_data, packed)) {
+      std::cout << "The pattern can not be sent as it is (format, LUT, dithering or group), use play." << std::endl;
+      return -1;
+    }
+    if (period_us < strip->getFrameGovernor().getFrameTimeUs()) {
+      period_us = strip->getFrameGovernor().getFrameTimeUs();
+      std::cout << "The strip takes at most " << strip->getFrameGovernor().getMaxFrameRate()
+                << " frames per second, the period is " << period_us << " us." << std::endl;
+    }
+    auto playback = std::make_unique<PacedPlayback>(strip, pattern_data, pattern_size, packed, offset_jump, period_us, loop);
+    if (!playback->start()) {
+      std::cout << "Failed to start the playback on device: " << name << std::endl;
+      return -1;
+    }
+    _pacedPlaybacks.push_back(std::move(playback));
+    return 0;
+  }
 };
\ No newline at end of file
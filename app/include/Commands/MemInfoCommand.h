@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ICommand.h"
+#include "Mainloop.h"
 #include <iostream>
 #include <iomanip>
 
@@ -17,7 +18,8 @@ public:
 
   const std::string getHelp() const override {
     return "Usage: meminfo\n"
-           "       Displays current stack and heap memory usage.";
+           "       Displays current stack and heap memory usage and the occupancy of\n"
+           "       the fixed task pools of both cores.";
   }
 
   // Executes the command
@@ -58,6 +60,18 @@ public:
     
     std::cout << "Total RAM:      " << std::setw(8) << total_ram << " bytes" << std::endl;
     std::cout << "Stack used:     " << std::setw(8) << stack_used << " bytes" << std::endl;
+    std::cout << std::endl;
+
+    // The task pools are allocated statically, show how much of them is in use
+    std::cout << "Task Pools:      regular    timed   signal requests" << std::endl;
+    for (int core = 0; core < 2; core++) {
+      Mainloop::PoolUsage usage = Mainloop::getInstance(core).getPoolUsage();
+      std::cout << "  Core " << core << ":     " << std::setw(4) << usage.regularTasks << "/" << std::setw(2)
+                << Mainloop::MAX_REGULAR_TASKS << "  " << std::setw(4) << usage.timedTasks << "/" << std::setw(2)
+                << Mainloop::MAX_TIMED_TASKS << "  " << std::setw(4) << usage.signalTasks << "/" << std::setw(2)
+                << Mainloop::MAX_SIGNAL_TASKS << "  " << std::setw(4) << usage.requests << "/" << std::setw(2)
+                << Mainloop::REQUEST_QUEUE_SIZE << std::endl;
+    }
     
     return 0; // Return 0 to indicate success
   }
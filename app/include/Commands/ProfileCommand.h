@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ICommand.h"
+#include "Mainloop.h"
+#include "Utils/Profiler.h"
+#include <iostream>
+
+class ProfileCommand : public ICommand {
+public:
+  // Returns the name of the command
+  const std::string getName() const override { return "profile"; }
+
+  const std::string getHelp() const override {
+    return "Usage: profile [start [rate_hz] [core] | stop | dump]\n"
+           "       Samples the program counter of one core with a timer interrupt and\n"
+           "       counts the hits per address. Without arguments the state is shown.\n"
+           "       start: Clears the samples and starts sampling, default 1000 Hz on core 0.\n"
+           "       stop: Stops sampling, the samples are kept until the next start.\n"
+           "       dump: Prints the samples, map them to functions with\n"
+           "             Helper-Tools/Profiler/symbolize.py and the .elf.map of the build.";
+  }
+
+  // Executes the command
+  int execute(const std::vector<std::string> &args) override {
+    if (args.size() >= 2 && args.size() <= 4 && args[1] == "start") {
+      uint32_t rate = args.size() >= 3 ? std::strtoul(args[2].c_str(), nullptr, 0) : 1000;
+      int core = args.size() == 4 ? std::atoi(args[3].c_str()) : 0;
+      if (core < 0 || core >= Mainloop::CORE_COUNT) {
+        std::cout << "Invalid core " << core << std::endl;
+        return -1;
+      }
+      if (Profiler::isRunning()) {
+        std::cout << "The profiler is running already" << std::endl;
+        return -1;
+      }
+      // the alarm interrupt is enabled on the core that starts the profiler
+      Mainloop::getInstance(core).invoke([rate]() { Profiler::start(rate); });
+      if (!waitUntilRunning(true)) {
+        std::cout << "Failed to start the profiler (invalid rate or no free alarm)" << std::endl;
+        return -1;
+      }
+    } else if (args.size() == 2 && args[1] == "stop") {
+      if (Profiler::isRunning()) {
+        Mainloop::getInstance(Profiler::core()).invoke([]() { Profiler::stop(); });
+        waitUntilRunning(false);
+      }
+    } else if (args.size() == 2 && args[1] == "dump") {
+      Profiler::dump();
+      return 0;
+    } else if (args.size() != 1) {
+      std::cout << getHelp() << std::endl;
+      return -1;
+    }
+
+    std::cout << "Profiler is " << (Profiler::isRunning() ? "running" : "stopped") << ", " << Profiler::rate()
+              << " Hz on core " << Profiler::core() << ": " << Profiler::samples() << " samples, "
+              << Profiler::dropped() << " dropped" << std::endl;
+    return 0;
+  }
+
+private:
+  // Requests to the other core run in its next Mainloop iteration
+  bool waitUntilRunning(bool running) {
+    absolute_time_t timeout = make_timeout_time_ms(100);
+    while (Profiler::isRunning() != running) {
+      if (time_reached(timeout)) {
+        return false;
+      }
+      tight_loop_contents();
+    }
+    return true;
+  }
+};
@@ -129,6 +129,11 @@ public:
     _signalTasks.push_back(task);
 
     TaskPID pid = _mainloop.registerSignalTask(&_signalTasks.back(), filter);
+    if (pid == Mainloop::INVALID_PID) {
+      _signalTasks.pop_back();
+      std::cout << "No free signal task, remove a signal handler first." << std::endl;
+      return -1;
+    }
     _signalTasks.back().setPID(pid);
 
     std::cout << "Registered signal handler for signal: " << SignalConverter::toString(filter) << "(with mask: " <<  ValueConverter::toString(filter.mask, IntegerStringFormat::HEX) << ") PID: " << pid << std::endl;
@@ -3,6 +3,7 @@
 #include "../ICommand.h"
 #include "Mainloop.h"
 #include <iostream>
+#include <sstream>
 
 class TaskCommand : public ICommand {
 public:
@@ -12,9 +13,12 @@ public:
   const std::string getName() const override { return "task"; }
 
   const std::string getHelp() const override {
-    return "Usage: task [pause <task_id> <milliseconds>]\n"
-           "       Shows the currently running tasks.\n"
-           "       pause <task_id> <milliseconds>: Pauses the task with the given ID for the specified duration.";
+    return "Usage: task [pause <task_id> <milliseconds>] [reset]\n"
+           "       Shows the currently running tasks with their execution time and\n"
+           "       the start lateness of timed tasks (p50 / p90 / p99 / max in us,\n"
+           "       percentiles are rounded up to the bucket limit 2^n-1).\n"
+           "       pause <task_id> <milliseconds>: Pauses the task with the given ID for the specified duration.\n"
+           "       reset: Clears the statistics of all tasks.";
   }
 
   // Executes the command
@@ -31,8 +35,30 @@ public:
       }
     }
 
+    if(args.size() == 2 && args[1] == "reset") {
+      for(int core = 0; core < Mainloop::CORE_COUNT; core++) {
+        Mainloop::getInstance(core).resetStatistics();
+      }
+      std::cout << "Task statistics have been reset." << std::endl;
+      return 0;
+    }
+
     std::cout << "Currently registered tasks:" << std::endl;
-    Mainloop::getInstance().OuptutTaskInformation();
+    Mainloop::getInstance(0).OuptutTaskInformation();
+
+    // core 1 takes a snapshot of its tasks into a buffer and hands it back, so
+    // only the console core writes to the output
+    auto &core1 = Mainloop::getInstance(1);
+    if (core1.isRunning()) {
+      Mainloop &console = Mainloop::getInstance();
+      core1.invoke([&core1, &console]() {
+        std::ostringstream snapshot;
+        snapshot << std::endl;
+        core1.OuptutTaskInformation(snapshot);
+        std::string text = snapshot.str();
+        console.invoke([text]() { std::cout << text << std::flush; });
+      });
+    }
     return 0; // Return 0 to indicate success
   }
 
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ICommand.h"
+#include "Mainloop.h"
+#include "Utils/Trace.h"
+#include <iostream>
+
+class TraceCommand : public ICommand {
+public:
+  // Returns the name of the command
+  const std::string getName() const override { return "trace"; }
+
+  const std::string getHelp() const override {
+    return "Usage: trace [on | off | clear | dump]\n"
+           "       Records task start and end, signals, interrupts, DMA and flash\n"
+           "       operations with their time in a ring of the last events per core.\n"
+           "       Without arguments the state of the recording is shown.\n"
+           "       on / off: Starts or pauses the recording.\n"
+           "       clear: Removes all recorded events.\n"
+           "       dump: Prints the events as hex, convert the output to Chrome trace JSON\n"
+           "             with Helper-Tools/TraceViewer/trace2chrome.py.";
+  }
+
+  // Executes the command
+  int execute(const std::vector<std::string> &args) override {
+    if (args.size() == 2 && args[1] == "on") {
+      Trace::enable(true);
+    } else if (args.size() == 2 && args[1] == "off") {
+      Trace::enable(false);
+    } else if (args.size() == 2 && args[1] == "clear") {
+      Trace::clear();
+    } else if (args.size() == 2 && args[1] == "dump") {
+      dump();
+      return 0;
+    } else if (args.size() != 1) {
+      std::cout << getHelp() << std::endl;
+      return -1;
+    }
+
+    std::cout << "Trace recording is " << (Trace::isEnabled() ? "on" : "off") << ", " << Trace::EVENT_COUNT
+              << " events per core" << std::endl;
+    for (int core = 0; core < Mainloop::CORE_COUNT; core++) {
+      std::cout << "  Core " << core << ": " << Trace::recorded(core) << " events recorded" << std::endl;
+    }
+    return 0;
+  }
+
+private:
+  void dump() {
+    std::cout << "trace 1" << std::endl;
+    for (int core = 0; core < Mainloop::CORE_COUNT; core++) {
+      Mainloop::getInstance(core).OutputTaskNames();
+    }
+    for (int core = 0; core < Mainloop::CORE_COUNT; core++) {
+      Trace::dump(core);
+    }
+    std::cout << "end" << std::endl;
+  }
+};
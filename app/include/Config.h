@@ -2,3 +2,6 @@
 
 #define UART_INTERFACE_NUMBER 1
 #define INTERFACE_NUMBER 0
+
+// Core that renders the LED frames (scrolling text, pattern playback)
+#define LED_RENDER_CORE 1
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <coroutine>
+#include <cstdint>
+
+#include "Mainloop.h"
+#include "Utils/FramePool.h"
+#include "Utils/Signal.h"
+
+class PIODevice;
+
+#ifndef MAINLOOP_COROUTINE_FRAMES
+#define MAINLOOP_COROUTINE_FRAMES 8
+#endif
+#ifndef MAINLOOP_COROUTINE_FRAME_SIZE
+#define MAINLOOP_COROUTINE_FRAME_SIZE 256
+#endif
+
+// Task written as a C++20 coroutine. The body runs on the Mainloop and
+// suspends on
+//   co_await Coroutine::sleepMs(ms);         woken by the timer queue
+//   co_await Coroutine::waitSignal(filter);  woken by a matching signal
+//   co_await Coroutine::dmaDone(device);     woken when the transfer of a
+//                                            PIODevice finished
+// and is not polled while it waits.
+//
+// The frame comes from a pool shared by both cores. When the pool is empty the
+// Coroutine is empty and registerCoroutine() returns INVALID_PID.
+// The Coroutine object owns the frame: it has to live until the task finished
+// (like an ITask), destroying it destroys the frame.
+class Coroutine {
+public:
+  using FramePool = ::FramePool<MAINLOOP_COROUTINE_FRAME_SIZE, MAINLOOP_COROUTINE_FRAMES>;
+
+  // Raised by the transfer done callback dmaDone() sets, "pio" + 4 * PIO + SM
+  static constexpr Signal TRANSFER_DONE_SIGNAL = 0x70696F00;
+
+  struct promise_type {
+    TaskPID pid = Mainloop::INVALID_PID;
+
+    Coroutine get_return_object() { return Coroutine(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    static Coroutine get_return_object_on_allocation_failure() { return Coroutine(); }
+
+    // started by the Mainloop, kept after the end so done() can be checked
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() {}
+
+    static void *operator new(size_t size) noexcept { return framePool().allocate(size); }
+    static void operator delete(void *frame) { framePool().release(frame); }
+  };
+
+  using Handle = std::coroutine_handle<promise_type>;
+
+  Coroutine() = default;
+  Coroutine(const Coroutine &) = delete;
+  Coroutine &operator=(const Coroutine &) = delete;
+  Coroutine(Coroutine &&other) noexcept : _handle(other._handle) { other._handle = nullptr; }
+  Coroutine &operator=(Coroutine &&other) noexcept {
+    if (this != &other) {
+      destroy();
+      _handle = other._handle;
+      other._handle = nullptr;
+    }
+    return *this;
+  }
+  ~Coroutine() { destroy(); }
+
+  explicit operator bool() const { return static_cast<bool>(_handle); }
+  bool done() const { return !_handle || _handle.done(); }
+  Handle handle() const { return _handle; }
+
+  static FramePool &framePool() {
+    static FramePool pool;
+    return pool;
+  }
+
+  struct SleepAwaiter {
+    uint32_t ms;
+
+    // always suspends, 0 resumes in the next iteration, so a loop of zero
+    // sleeps does not hold the core
+    bool await_ready() const { return false; }
+    void await_suspend(Handle handle) const { Mainloop::getInstance().sleepTask(handle.promise().pid, ms); }
+    void await_resume() const {}
+  };
+
+  struct SignalAwaiter {
+    SignalFilter filter;
+
+    bool await_ready() const { return false; }
+    void await_suspend(Handle handle) const { Mainloop::getInstance().waitForSignal(handle.promise().pid, filter); }
+    void await_resume() const {}
+  };
+
+  // Takes over the transfer done callback of the device, so not for devices
+  // of a PIOFrameBuffer. Resumes right away when nothing is sent.
+  struct DmaAwaiter {
+    PIODevice &device;
+
+    bool await_ready() const;
+    bool await_suspend(Handle handle) const;
+    void await_resume() const {}
+  };
+
+  static SleepAwaiter sleepMs(uint32_t ms) { return {ms}; }
+  static SignalAwaiter waitSignal(SignalFilter filter) { return {filter}; }
+  static SignalAwaiter waitSignal(Signal signal) { return {{signal, 0xFFFFFFFF}}; }
+  static DmaAwaiter dmaDone(PIODevice &device) { return {device}; }
+
+private:
+  explicit Coroutine(Handle handle) : _handle(handle) {}
+
+  void destroy() {
+    if (_handle) {
+      _handle.destroy();
+      _handle = nullptr;
+    }
+  }
+
+  Handle _handle;
+};
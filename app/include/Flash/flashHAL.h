@@ -1,6 +1,7 @@
 #include "hardware/flash.h"
 #include "pico/flash.h"
 #include "pico/stdlib.h"
+#include "Utils/Trace.h"
 #include <cstring>
 #include <stdexcept>
 
@@ -16,10 +17,12 @@ public:
    */
   static void flash_range_erase(uint32_t flash_offs, size_t count) {
     flash_param_t params = {flash_offs, nullptr, count};
+    Trace::record(Trace::Type::FlashErase, flash_offs);
     ::flash_safe_execute([](void* p) {
       flash_param_t* params = static_cast<flash_param_t*>(p);
       ::flash_range_erase(params->flash_offset, params->size);
     }, &params, UINT32_MAX);
+    Trace::record(Trace::Type::FlashDone, flash_offs);
   }
 
   /*! \brief  Program flash
@@ -34,10 +37,12 @@ public:
   static void flash_range_program(uint32_t flash_offs, const uint8_t *data,
                                   size_t count) {
     flash_param_t params = {flash_offs, data, count};
+    Trace::record(Trace::Type::FlashProgram, flash_offs);
     ::flash_safe_execute([](void* p) {
       flash_param_t* params = static_cast<flash_param_t*>(p);
       ::flash_range_program(params->flash_offset, params->data, params->size);
     }, &params, UINT32_MAX);
+    Trace::record(Trace::Type::FlashDone, flash_offs);
   }
 
   /*! \brief Get flash unique 64 bit identifier
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Bit plane layout for driving several WS2812 strips from one PIO state
+// machine (WS2812Parallel). Every bit time of the strips is one plane with
+// one bit per strip (bit s = strip s): 1 byte for up to 8 strips, 2 bytes for
+// up to 16. The planes of an LED follow each other, the first sent bit (bit 31
+// of the pixel word) first:
+//   out[(led * bitsPerPixel + k) * width + group] = bit (31 - k) of strips 8*group..8*group+7
+namespace BitPlane {
+
+// Bytes per plane
+inline size_t planeWidth(size_t stripCount) { return stripCount <= 8 ? 1 : 2; }
+
+// Bytes of the planes of a frame
+inline size_t frameSize(size_t stripCount, size_t ledCount, unsigned bitsPerPixel) {
+  return ledCount * bitsPerPixel * planeWidth(stripCount);
+}
+
+// Swaps the bits selected by mask in b with the bits shift positions above them in a
+inline void swapBits(uint32_t &a, uint32_t &b, unsigned shift, uint32_t mask) {
+  uint32_t t = ((a >> shift) ^ b) & mask;
+  b ^= t;
+  a ^= t << shift;
+}
+
+// Transposes the 8x8 bit blocks of the byte lanes of 8 words in place:
+// afterwards bit b of byte c in word r is bit r of byte c in the former word b
+inline void transpose8x8(uint32_t (&p)[8]) {
+  swapBits(p[0], p[4], 4, 0x0F0F0F0F);
+  swapBits(p[1], p[5], 4, 0x0F0F0F0F);
+  swapBits(p[2], p[6], 4, 0x0F0F0F0F);
+  swapBits(p[3], p[7], 4, 0x0F0F0F0F);
+  swapBits(p[0], p[2], 2, 0x33333333);
+  swapBits(p[1], p[3], 2, 0x33333333);
+  swapBits(p[4], p[6], 2, 0x33333333);
+  swapBits(p[5], p[7], 2, 0x33333333);
+  swapBits(p[0], p[1], 1, 0x55555555);
+  swapBits(p[2], p[3], 1, 0x55555555);
+  swapBits(p[4], p[5], 1, 0x55555555);
+  swapBits(p[6], p[7], 1, 0x55555555);
+}
+
+// Writes the planes of one group of 8 strips for one LED, the lanes (color
+// bytes) from the first sent one down
+template <size_t Width>
+inline void storePlanes(const uint32_t (&p)[8], unsigned lanes, uint8_t *plane) {
+  for (int lane = 3; lane > 3 - static_cast<int>(lanes); lane--) {
+    const unsigned shift = lane * 8;
+    for (int row = 7; row >= 0; row--, plane += Width) {
+      *plane = static_cast<uint8_t>(p[row] >> shift);
+    }
+  }
+}
+
+// load(strip, led) returns a pixel as 0xRRGGBBWW
+template <size_t Width, typename Load>
+inline void transposeGroups(size_t stripCount, size_t ledCount, unsigned bitsPerPixel, uint8_t *out, Load load) {
+  const unsigned lanes = bitsPerPixel / 8;
+  for (size_t led = 0; led < ledCount; led++) {
+    for (size_t group = 0; group < Width; group++) {
+      uint32_t p[8];
+      for (size_t s = 0; s < 8; s++) {
+        size_t strip = group * 8 + s;
+        p[s] = strip < stripCount ? load(strip, led) : 0;
+      }
+      transpose8x8(p);
+      storePlanes<Width>(p, lanes, out + group);
+    }
+    out += bitsPerPixel * Width;
+  }
+}
+
+struct Unchanged {
+  uint32_t operator()(uint32_t pixel) const { return pixel; }
+};
+
+// Converts one frame per strip (stripCount <= 16, ledCount pixels each,
+// bitsPerPixel 8, 16, 24 or 32) into planes. Strips of a group that do not
+// exist are sent as 0. map is applied to every pixel as it is loaded.
+template <typename Map = Unchanged>
+inline void transpose(const uint32_t *const *strips, size_t stripCount, size_t ledCount, unsigned bitsPerPixel,
+                      uint8_t *out, Map map = Map()) {
+  auto load = [strips, &map](size_t strip, size_t led) { return map(strips[strip][led]); };
+  if (planeWidth(stripCount) == 1) {
+    transposeGroups<1>(stripCount, ledCount, bitsPerPixel, out, load);
+  } else {
+    transposeGroups<2>(stripCount, ledCount, bitsPerPixel, out, load);
+  }
+}
+
+// The same for packed strips, 3 bytes per LED in the order they are sent
+// (bitsPerPixel 24)
+template <typename Map = Unchanged>
+inline void transposePacked(const uint8_t *const *strips, size_t stripCount, size_t ledCount, uint8_t *out,
+                            Map map = Map()) {
+  auto load = [strips, &map](size_t strip, size_t led) {
+    const uint8_t *p = strips[strip] + led * 3;
+    return map(static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+               static_cast<uint32_t>(p[2]) << 8);
+  };
+  if (planeWidth(stripCount) == 1) {
+    transposeGroups<1>(stripCount, ledCount, 24, out, load);
+  } else {
+    transposeGroups<2>(stripCount, ledCount, 24, out, load);
+  }
+}
+
+} // namespace BitPlane
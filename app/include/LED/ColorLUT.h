@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Output stage of the LED strips: gamma, brightness and white balance per
+// channel in one 256 entry table per byte lane, plus the color order.
+// Pixels are 0xRRGGBBWW, the lane of bits 31..24 is sent first. With the
+// default settings the stage is skipped.
+class ColorLUT {
+public:
+  ColorLUT();
+
+  // 0 (off) .. 255 (full)
+  void setBrightness(uint8_t brightness);
+  uint8_t getBrightness() const { return _brightness; }
+  // 1.0 is linear, 2.2 .. 2.8 match the eye
+  bool setGamma(float gamma);
+  float getGamma() const { return _gamma; }
+  // Scale per channel as a pixel (0xRRGGBBWW, 0xFF = unchanged)
+  void setBalance(uint32_t balance);
+  uint32_t getBalance() const { return _balance; }
+  // Channels in the order they are sent, e.g. "GRB"; missing channels follow
+  // in RGBW order
+  bool setOrder(const std::string& order);
+  const std::string& getOrder() const { return _order; }
+
+  bool isIdentity() const { return _identity; }
+  // Changes with every setting
+  uint32_t getRevision() const { return _revision; }
+  // Position of the input channel of an output lane (lane 0 is sent first)
+  unsigned getShift(unsigned lane) const { return _shift[lane]; }
+  // Output of a lane for an input channel value with 8 fractional bits
+  // (0 .. 0xFF00), for temporal dithering
+  uint16_t map16(unsigned lane, uint8_t value) const;
+
+  uint32_t map(uint32_t pixel) const {
+    return static_cast<uint32_t>(_table[0][(pixel >> _shift[0]) & 0xFF]) << 24 |
+           static_cast<uint32_t>(_table[1][(pixel >> _shift[1]) & 0xFF]) << 16 |
+           static_cast<uint32_t>(_table[2][(pixel >> _shift[2]) & 0xFF]) << 8 |
+           static_cast<uint32_t>(_table[3][(pixel >> _shift[3]) & 0xFF]);
+  }
+
+  // in and out may be the same buffer
+  void apply(const uint32_t* in, uint32_t* out, size_t count) const;
+
+private:
+  uint8_t _table[4][256]; // per output lane, lane 0 is bits 31..24
+  uint8_t _shift[4];      // position of the input channel of each output lane
+  bool _identity;
+  uint32_t _revision = 0;
+
+  uint8_t _brightness = 255;
+  float _gamma = 1.0f;
+  uint32_t _balance = 0xFFFFFFFF;
+  std::string _order = "RGBW";
+
+  void rebuild();
+  float output(unsigned lane, uint8_t value) const; // 0 .. 255
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+// Frame pacing of an LED strip. A strip takes one frame per frame time (the
+// bits of a frame at the bit rate plus the reset time), a frame presented
+// while the previous one still waits replaces it (dropped). Submitters ask
+// admit() for the frames that became due: while the strip is busy they are
+// coalesced into the next call, so a playback keeps its speed on long strips
+// instead of falling behind.
+class FrameGovernor {
+public:
+  explicit FrameGovernor(uint32_t frameTimeUs) : _frameTimeUs(frameTimeUs > 0 ? frameTimeUs : 1) {}
+
+  uint32_t getFrameTimeUs() const { return _frameTimeUs; }
+  // Frames per second the strip can sustain
+  uint32_t getMaxFrameRate() const { return 1000000 / _frameTimeUs; }
+
+  // due: frames that became due since the last call, queued: the strip did not
+  // take the previous frame yet. Returns the frames to advance, the last one
+  // is shown, or 0 to skip this call.
+  uint32_t admit(uint32_t due, bool queued) {
+    _due += due;
+    if (queued || _due == 0) {
+      return 0;
+    }
+    uint32_t frames = _due;
+    _due = 0;
+    _coalesced += frames - 1;
+    return frames;
+  }
+
+  // Called by the strip for every presented frame
+  void presented(bool replaced) {
+    _presented++;
+    if (replaced) {
+      _dropped++;
+    }
+  }
+
+  uint32_t getPresented() const { return _presented; }
+  // Presented, but replaced before they were sent
+  uint32_t getDropped() const { return _dropped; }
+  // Due, but skipped by admit()
+  uint32_t getCoalesced() const { return _coalesced; }
+
+private:
+  uint32_t _frameTimeUs;
+  uint32_t _due = 0;
+  uint32_t _presented = 0;
+  uint32_t _dropped = 0;
+  uint32_t _coalesced = 0;
+};
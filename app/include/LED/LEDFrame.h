@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "LED/ColorLUT.h"
+#include "LED/PackedPixel.h"
+#include "LED/TemporalDither.h"
+
+// Write access to a frame of a strip in its storage format. The color LUT of
+// the strip is applied as the pixels are written. With temporal dithering the
+// pixels go into the 16 bit frame of the dither stage instead.
+class LEDFrame {
+public:
+  LEDFrame(void* data, size_t count, bool packed, const ColorLUT& lut)
+      : _data(data), _count(count), _packed(packed), _lut(lut) {}
+  LEDFrame(TemporalDither& dither, const ColorLUT& lut)
+      : _data(nullptr), _count(dither.size()), _packed(false), _lut(lut), _dither(&dither) {}
+
+  size_t size() const { return _count; }
+
+  void set(size_t index, uint32_t pixel) {
+    if (_dither) {
+      _dither->set(index, pixel);
+      return;
+    }
+    if (!_lut.isIdentity()) {
+      pixel = _lut.map(pixel);
+    }
+    if (_packed) {
+      PackedPixel::store(static_cast<uint8_t*>(_data) + index * PackedPixel::BYTES, pixel);
+    } else {
+      static_cast<uint32_t*>(_data)[index] = pixel;
+    }
+  }
+
+  // Sets the pixels from (inclusive) to to (exclusive)
+  void fill(size_t from, size_t to, uint32_t pixel) {
+    for (size_t i = from; i < to; i++) {
+      set(i, pixel);
+    }
+  }
+
+private:
+  void* _data;
+  size_t _count;
+  bool _packed;
+  const ColorLUT& _lut;
+  TemporalDither* _dither = nullptr;
+};
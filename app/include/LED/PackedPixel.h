@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Pixel storage of the LED strips. Pixels are passed as 0xRRGGBBWW words,
+// strips with 24 bits per pixel store them packed: 3 bytes per LED in the
+// order they are sent (bits 31..24 first), a quarter less RAM per frame.
+namespace PackedPixel {
+
+constexpr size_t BYTES = 3;
+
+inline uint32_t load(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8;
+}
+
+inline void store(uint8_t* p, uint32_t pixel) {
+  p[0] = static_cast<uint8_t>(pixel >> 24);
+  p[1] = static_cast<uint8_t>(pixel >> 16);
+  p[2] = static_cast<uint8_t>(pixel >> 8);
+}
+
+} // namespace PackedPixel
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Current budget of an LED strip. The current of a frame is estimated from the
+// sum of its channel values as they are sent (the ColorLUT applied): every
+// channel draws up to getChannelMilliamps() at 255, every LED draws its idle
+// current. A frame above the budget is scaled down as a whole, so a pattern
+// going full white dims instead of browning out the supply.
+class PowerLimiter {
+public:
+  // budget_ma: 0 disables the limiter
+  explicit PowerLimiter(uint32_t budget_ma = 0, uint32_t channel_ma = 20, uint32_t idle_ua = 1000)
+      : _budgetMa(budget_ma), _channelMa(channel_ma), _idleUa(idle_ua) {}
+
+  bool isEnabled() const { return _budgetMa > 0; }
+  uint32_t getBudget() const { return _budgetMa; }
+  void setBudget(uint32_t budget_ma) { _budgetMa = budget_ma; }
+  uint32_t getChannelMilliamps() const { return _channelMa; }
+  void setChannelMilliamps(uint32_t channel_ma) { _channelMa = channel_ma; }
+
+  // Estimates the current of a frame of leds LEDs (data: the channel bytes of
+  // the frame, word aligned, bytes of them) and scales it into the budget.
+  // Returns true if the frame was scaled.
+  bool limit(uint8_t* data, size_t bytes, size_t leds);
+
+  // Sum of the channel values of a frame, 4 bytes at a time
+  static uint32_t channelSum(const uint8_t* data, size_t bytes);
+  // Multiplies every byte with scale / 256 (scale 0 .. 256)
+  static void scale(uint8_t* data, size_t bytes, uint32_t scale);
+
+  // Estimated current of the last frame before it was scaled, in mA
+  uint32_t getCurrent() const { return _currentMa; }
+  // Frames that were scaled down
+  uint32_t getClipped() const { return _clipped; }
+
+private:
+  uint32_t _budgetMa;
+  uint32_t _channelMa;
+  uint32_t _idleUa;
+  uint32_t _currentMa = 0;
+  uint32_t _clipped = 0;
+};
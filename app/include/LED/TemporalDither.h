@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "LED/ColorLUT.h"
+
+// Temporal dithering for low brightness levels. The frame is kept with 16 bits
+// per channel (8 fractional bits, the ColorLUT applied) and every render()
+// emits an 8 bit frame. The rounding error of each channel is carried into its
+// next frame, so the average over a few frames matches the 16 bit value
+// instead of banding at the 8 bit steps.
+class TemporalDither {
+public:
+  // lanes: bytes per pixel that are sent (3 for RGB, 4 for RGBW)
+  TemporalDither(size_t ledCount, unsigned lanes, const ColorLUT& lut);
+
+  size_t size() const { return _count; }
+
+  // Picks up changed LUT settings, call before setting the pixels of a frame
+  void update();
+
+  // Sets a pixel (0xRRGGBBWW) of the 16 bit frame
+  void set(size_t index, uint32_t pixel) {
+    uint16_t* channels = &_frame[index * _lanes];
+    for (unsigned lane = 0; lane < _lanes; lane++) {
+      channels[lane] = _table[lane][(pixel >> _lut.getShift(lane)) & 0xFF];
+    }
+  }
+
+  // Emits the next 8 bit frame: packed (3 bytes per LED, see PackedPixel) or
+  // one 0xRRGGBBWW word per LED
+  void render(uint8_t* out, bool packed);
+
+private:
+  size_t _count;
+  unsigned _lanes;
+  const ColorLUT& _lut;
+  uint32_t _revision;
+
+  std::vector<uint16_t> _frame; // per LED and lane in send order
+  std::vector<uint8_t> _error;  // fractional part carried to the next frame
+  uint16_t _table[4][256];
+};
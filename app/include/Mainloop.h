@@ -1,41 +1,149 @@
 #pragma once
 
 #include "pico/stdlib.h"
+#include "pico/sync.h"
+#include "pico/util/queue.h"
 #include <cstdint>
-#include <functional>
+#include <cstring>
 #include <vector>
 #include <iostream>
 
 #include "ITask.h"
+#include "Utils/FixedVector.h"
+#include "Utils/InplaceFunction.h"
+#include "Utils/LatencyHistogram.h"
 #include "Utils/Signal.h"
+#include "Utils/SignalIndex.h"
+#include "Utils/SignalRing.h"
+#include "Utils/TimerQueue.h"
+
+// There is one Mainloop per core. Core 0 runs the console, USB and everything
+// registered without a core affinity. Core 1 is started with startCore1() and
+// runs the tasks registered with core affinity 1.
+//
+// All functions may be called from both cores: when the task (or the instance)
+// belongs to the other core, the request is queued and executed by the owning
+// core at the start of its next iteration.
+//
+// A TaskPID encodes the slot of the task in the task table of its core and the
+// generation of that slot, so lookups are O(1) and PIDs of removed tasks are
+// rejected even when the slot has been reused.
+//
+// The loop is tickless: when no signal task is flagged, no timed task is due
+// and every regular task is sleeping or has called reportIdle(), the core waits
+// for an event (interrupt, request of the other core) or the next deadline.
+//
+// Registering and removing tasks does not allocate: the task records come
+// from fixed pools per core, the functions are stored in place. The sizes are
+// set by the build.
+
+// Number of tasks of each kind per core
+#ifndef MAINLOOP_MAX_REGULAR_TASKS
+#define MAINLOOP_MAX_REGULAR_TASKS 16
+#endif
+#ifndef MAINLOOP_MAX_TIMED_TASKS
+#define MAINLOOP_MAX_TIMED_TASKS 16
+#endif
+#ifndef MAINLOOP_MAX_SIGNAL_TASKS
+#define MAINLOOP_MAX_SIGNAL_TASKS 24
+#endif
+// Bytes available for the captures of a task function and of a request
+#ifndef MAINLOOP_FUNCTION_SIZE
+#define MAINLOOP_FUNCTION_SIZE 16
+#endif
+#ifndef MAINLOOP_REQUEST_SIZE
+#define MAINLOOP_REQUEST_SIZE 96
+#endif
+// Longer task names are truncated
+#ifndef MAINLOOP_TASK_NAME_LENGTH
+#define MAINLOOP_TASK_NAME_LENGTH 24
+#endif
+
+class Coroutine;
 
 class Mainloop {
 public:
-  using Function = std::function<bool(TaskPID)>;
+  using Function = InplaceFunction<bool(TaskPID), MAINLOOP_FUNCTION_SIZE>;
+  using Request = InplaceFunction<void(), MAINLOOP_REQUEST_SIZE>;
+
+  static constexpr int CORE_COUNT = 2;
+  // Use the core of the Mainloop instance the task is registered at
+  static constexpr int THIS_CORE = -1;
+  // Interval of timed tasks that run once per sleepTask() or waitForSignal()
+  // and are not scheduled otherwise
+  static constexpr int32_t ON_DEMAND = -2;
+
+  // Priority of regular tasks. Timed tasks always run first (earliest deadline
+  // first), then flagged signal tasks, then the regular tasks by priority.
+  // Low priority tasks only run while the iteration is within its time budget,
+  // the remaining ones continue in the next iteration.
+  enum class Priority : uint8_t {
+    High,   // e.g. the workers draining UART and USB buffers, the receive
+            // FIFOs overflow when they wait behind other regular work
+    Normal,
+    Low     // e.g. the console
+  };
+
+  // What happens with the executions of a timed task that were missed because
+  // the core was busy. The start times always stay on the grid of the initial
+  // schedule, so the task does not drift.
+  enum class OverrunPolicy : uint8_t {
+    Skip,     // drop the missed executions (default)
+    CatchUp,  // execute the missed ones back to back (at most MAX_CATCH_UP)
+    Coalesce  // execute once, getCoalescedPeriods() tells how many were due
+  };
+  static constexpr uint32_t MAX_CATCH_UP = 8;
+
+  // Occupancy of the pools of one core
+  struct PoolUsage {
+    uint16_t regularTasks;
+    uint16_t timedTasks;
+    uint16_t signalTasks;
+    uint16_t requests;
+  };
 
 private:
+  struct TaskName {
+    char text[MAINLOOP_TASK_NAME_LENGTH];
+
+    TaskName(const std::string &name) {
+      strncpy(text, name.c_str(), sizeof(text) - 1);
+      text[sizeof(text) - 1] = '\0';
+    }
+  };
+
   struct TaskInfo {
     TaskPID pid;
-    std::string name;
+    TaskName name;
     Function func;
 
     uint64_t startTime;
-    uint32_t meanTime;
-    uint32_t maxTime;
+    LatencyHistogram executionTime;
   };
 
   struct RegularTaskInfo {
     struct TaskInfo info;
 
     uint32_t sleepUntil;
+    Priority priority;
   };
 
   struct TimedTaskInfo {
     struct TaskInfo info;
 
-    bool execute;
+    bool finished;
     int32_t intervalMs;
     uint32_t nextExecution;
+    // nextExecution is in the timer queue, not set for tasks that ran once and
+    // wait for sleepTask() or a signal
+    bool queued;
+    OverrunPolicy overrunPolicy;
+    // Number of executions that could not start in time
+    uint32_t overruns;
+    // Actual start minus scheduled start
+    LatencyHistogram lateness;
+    // Registered in _signalWaiters
+    bool waitsForSignal;
   };
 
   struct SignalTaskInfo {
@@ -45,144 +153,268 @@ private:
     bool execute;
   };
 
+  enum class TaskKind : uint8_t {
+    Regular,
+    Timed,
+    Signal,
+    Free,
+    Reserved // PID handed out, the task is inserted by the owning core
+  };
+
+  // Entry of the task table, index is the position in the pool of the kind
+  struct TaskSlot {
+    uint16_t generation;
+    TaskKind kind;
+    TaskKind reservedKind;
+    bool killRequested;
+    uint16_t index;
+    uint16_t nextFree;
+  };
+
 public:
+  // Returns the Mainloop of the calling core
   static Mainloop& getInstance();
+  static Mainloop& getInstance(int core);
+
+  // Returned by the register functions when the pool of the kind is full
+  static constexpr TaskPID INVALID_PID = -1;
+  static constexpr uint32_t MAX_REGULAR_TASKS = MAINLOOP_MAX_REGULAR_TASKS;
+  static constexpr uint32_t MAX_TIMED_TASKS = MAINLOOP_MAX_TIMED_TASKS;
+  static constexpr uint32_t MAX_SIGNAL_TASKS = MAINLOOP_MAX_SIGNAL_TASKS;
+  // Maximum number of tasks per core
+  static constexpr uint32_t MAX_TASKS = MAX_REGULAR_TASKS + MAX_TIMED_TASKS + MAX_SIGNAL_TASKS;
+  static constexpr int REQUEST_QUEUE_SIZE = 16;
+
+  // Returns the core that owns the task
+  static int getTaskCore(TaskPID handle) {
+    return (handle & CORE1_PID_FLAG) != 0 ? 1 : 0;
+  }
+
+  int getCore() const { return _core; }
+  bool isRunning() const { return _running; }
 
   // Register a function to be executed in every mainloop iteration
-  TaskPID registerRegularTask(const std::string &name, Function func) {
-    TaskPID handle = _nextTaskPID++;
-    _regularTasks.push_back({{handle, name, func, 0, 0, 0}, 0});
-    return handle;
-  }
+  TaskPID registerRegularTask(const std::string &name, Function func, int core = THIS_CORE);
 
-  TaskPID registerRegularTask(ITask *task) {
-    return registerRegularTask(task->getName(), [task](TaskPID pid) { return task->ExecuteTask(pid); });
+  TaskPID registerRegularTask(ITask *task, int core = THIS_CORE) {
+    return registerRegularTask(task->getName(), [task](TaskPID pid) { return task->ExecuteTask(pid); }, core);
   }
 
-  bool sleepTask(TaskPID handle, uint32_t sleepTimeMs) {
-    for (auto &task : _regularTasks) {
-      if (task.info.pid == handle) {
-        task.sleepUntil = _systickCounter + sleepTimeMs;
-        return true;
-      }
-    }
-    for (auto &task : _timedTasks) {
-      if (task.info.pid == handle) {
-        task.nextExecution = _systickCounter + sleepTimeMs;
-        task.execute = false;
-        return true;
-      }
-    }
-    return false;
-  }
+  // A timed task that sleeps 0 ms while it runs is executed again in the next
+  // iteration, not in the same pass
+  bool sleepTask(TaskPID handle, uint32_t sleepTimeMs);
+
+  // Only tasks of the calling core can be queried
+  bool isTaskSleeping(TaskPID handle) const;
+
+  // Only regular tasks have a priority, they start with Priority::Normal
+  bool setTaskPriority(TaskPID handle, Priority priority);
+
+  // Time of an iteration after which low priority tasks are deferred
+  void setLowPriorityBudget(uint32_t budgetUs) { _lowPriorityBudgetUs = budgetUs; }
+
+  // Returns true when the current iteration has used up its time budget.
+  // Tasks doing a lot of work in pieces should return and continue in the
+  // next iteration.
+  bool shouldYield() const { return time_us_64() - _iterationStart >= _lowPriorityBudgetUs; }
+
+  // Called by a regular task when it has nothing to do in this iteration.
+  // Tasks that never report idle keep the core busy.
+  void reportIdle() { _taskIdle = true; }
 
-  TaskPID registerTimedTask(ITask *task, int32_t intervalMs, int32_t initialDelayMs = 0) {
-    return registerTimedTask(task->getName(), [task](TaskPID pid) { return task->ExecuteTask(pid); }, intervalMs, initialDelayMs);
+  TaskPID registerTimedTask(ITask *task, int32_t intervalMs, int32_t initialDelayMs = 0, int core = THIS_CORE) {
+    return registerTimedTask(task->getName(), [task](TaskPID pid) { return task->ExecuteTask(pid); }, intervalMs, initialDelayMs, core);
   }
 
   // Register a function to be executed every x ms
-  TaskPID registerTimedTask(const std::string &name, Function func, int32_t intervalMs, int32_t initialDelayMs = 0) {
-    TaskPID handle = _nextTaskPID++;
-    TimedTaskInfo taskInfo{{handle, name, func, 0, 0, 0}, initialDelayMs == 0, intervalMs, _systickCounter + initialDelayMs};
-    if(initialDelayMs == 0){
-      taskInfo.nextExecution += intervalMs;
-    }
-    _timedTasks.push_back(taskInfo);
-    return handle;
-  }
+  // With an initial delay of 0 the task is executed in the next mainloop iteration
+  // With an interval of 0 it is executed once and then waits like an ON_DEMAND task
+  TaskPID registerTimedTask(const std::string &name, Function func, int32_t intervalMs, int32_t initialDelayMs = 0, int core = THIS_CORE);
 
   // Register a function to be executed once after y ms
-  TaskPID registerDelayedTask(const std::string &name, Function func, int32_t delayMs) {
-    return registerTimedTask(name, func, -1, delayMs);
+  TaskPID registerDelayedTask(const std::string &name, Function func, int32_t delayMs, int core = THIS_CORE) {
+    return registerTimedTask(name, func, -1, delayMs, core);
   }
 
-  bool modifyTimedTaskInterval(TaskPID handle, int32_t newIntervalMs) {
-    for (auto &task : _timedTasks) {
-      if (task.info.pid == handle) {
-        int32_t difference = newIntervalMs - task.intervalMs;
-        task.nextExecution = task.nextExecution + difference;
-        task.intervalMs = newIntervalMs;
-        if (task.nextExecution <= _systickCounter) {
-          task.nextExecution = _systickCounter + newIntervalMs;
-          task.execute = true;
-        }
-        
-        return true;
-      }
-    }
-    return false;
-  }
+  // Runs the coroutine as an ON_DEMAND timed task, see Coroutine.h.
+  // Returns INVALID_PID for an empty coroutine (no frame was available).
+  TaskPID registerCoroutine(const std::string &name, Coroutine &coroutine, int core = THIS_CORE);
 
-  TaskPID registerSignalTask(ITask *task, SignalFilter filter) {
-    return registerSignalTask(task->getName(), [task](TaskPID pid) { return task->ExecuteTask(pid); }, filter);
-  }
+  // Schedules the timed task once when the next signal matching the filter
+  // arrives. Only for tasks of the calling core.
+  bool waitForSignal(TaskPID handle, SignalFilter filter);
 
-  TaskPID registerSignalTask(const std::string &name, Function func, SignalFilter filter) {
-    TaskPID handle = _nextTaskPID++;
-    _signalTasks.push_back({{handle, name, func, 0, 0, 0}, filter, false});
-    return handle;
-  }
+  bool modifyTimedTaskInterval(TaskPID handle, int32_t newIntervalMs);
 
-  TaskPID registerSignalTask(ITask *task, Signal signal) {
-    return registerSignalTask(task, {signal, 0xFFFFFFFF});
-  }
+  bool setOverrunPolicy(TaskPID handle, OverrunPolicy policy);
 
-  TaskPID registerSignalTask(const std::string &name, Function func, Signal signal) {
-    return registerSignalTask(name, func, {signal, 0xFFFFFFFF});
-  }
+  // Number of intervals the currently running timed task stands for, more
+  // than 1 when missed executions were coalesced
+  uint32_t getCoalescedPeriods() const { return _coalescedPeriods; }
 
-  SignalFilter getSignalFilter(TaskPID handle) const {
-    for (auto &task : _signalTasks) {
-      if (task.info.pid == handle) {
-        return task.filter;
-      }
-    }
-    return {0, 0};
+  TaskPID registerSignalTask(ITask *task, SignalFilter filter, int core = THIS_CORE) {
+    return registerSignalTask(task->getName(), [task](TaskPID pid) { return task->ExecuteTask(pid); }, filter, core);
   }
 
-  void triggerSignal(Signal signal) {
-    for (auto &task : _signalTasks) {
-      if(((signal ^ task.filter.signal) & task.filter.mask) == 0){
-        task.execute = true;
-      }
-    }
+  TaskPID registerSignalTask(const std::string &name, Function func, SignalFilter filter, int core = THIS_CORE);
+
+  TaskPID registerSignalTask(ITask *task, Signal signal, int core = THIS_CORE) {
+    return registerSignalTask(task, {signal, 0xFFFFFFFF}, core);
   }
 
-  void killTask(TaskPID handle) {
-    _tasksToKill.push_back(handle);
+  TaskPID registerSignalTask(const std::string &name, Function func, Signal signal, int core = THIS_CORE) {
+    return registerSignalTask(name, func, {signal, 0xFFFFFFFF}, core);
   }
 
+  // Only tasks of the calling core can be queried
+  SignalFilter getSignalFilter(TaskPID handle) const;
+
+  // Delivers the signal to the signal tasks of all cores. Safe to call from
+  // interrupts: the signal is only queued for the Mainloop of the calling core,
+  // which matches the filters in thread context.
+  void triggerSignal(Signal signal);
+
+  void killTask(TaskPID handle);
+
+  // Executes the function in the context of this Mainloop. When called from the
+  // other core the function is queued and executed in the next iteration.
+  // Must not be called from an interrupt.
+  void invoke(Request func);
+
   // Start the mainloop
   void start();
 
+  // Start the Mainloop of core 1, must be called from core 0
+  static void startCore1();
+
   // Stop the mainloop
   void stop() { _running = false; }
 
-  // Simulated SysTick functions
-  uint32_t getSysTick() const { return _systickCounter; }
+  // Milliseconds since boot, the same time base on both cores
+  uint32_t getSysTick() const { return static_cast<uint32_t>(time_us_64() / 1000); }
 
-  void OuptutTaskInformation() const;
+  // Writes the task table of this Mainloop. Call it on the owning core, the
+  // other core prints into a buffer and hands it to the console core.
+  void OuptutTaskInformation(std::ostream &out = std::cout) const;
 
-private:
-  std::vector<RegularTaskInfo> _regularTasks;
-  std::vector<TimedTaskInfo> _timedTasks;
-  std::vector<SignalTaskInfo> _signalTasks;
+  // Prints "task <pid> <name>" for every task, used to label trace dumps.
+  // Names only change when tasks are added or removed, so this may be called
+  // for the Mainloop of the other core.
+  void OutputTaskNames() const;
+
+  // Clears the execution time and lateness statistics of all tasks of this core
+  void resetStatistics();
 
-  std::vector<TaskPID> _tasksToKill;
+  PoolUsage getPoolUsage() const;
+
+private:
+  // PIDs of tasks running on core 1 have this bit set
+  static constexpr TaskPID CORE1_PID_FLAG = 0x8000;
+  // PID layout: generation (bits 16..30) | core flag | slot (bits 0..14)
+  static constexpr TaskPID SLOT_MASK = 0x7FFF;
+  static constexpr int GENERATION_SHIFT = 16;
+  static constexpr uint16_t GENERATION_MASK = 0x7FFF;
+  static constexpr uint16_t NO_SLOT = 0xFFFF;
+  // Rescheduling leaves stale entries, the queue is compacted when it is full
+  static constexpr size_t TIMER_QUEUE_CAPACITY = 2 * MAX_TIMED_TASKS;
+  // Duplicates are coalesced, the ring only fills with distinct signals (e.g.
+  // a script that sets many variables within one iteration)
+  static constexpr uint32_t PENDING_SIGNAL_COUNT = 128;
+  // Takes everything the other core drains from its ring in one iteration
+  static constexpr int SIGNAL_QUEUE_SIZE = PENDING_SIGNAL_COUNT;
+  // Upper limit for a single idle wait
+  static constexpr uint32_t MAX_IDLE_MS = 100;
+  static constexpr uint32_t LOAD_WINDOW_US = 1000000;
+  static constexpr uint32_t DEFAULT_LOW_PRIORITY_BUDGET_US = 1000;
+
+  int _core;
+
+  FixedVector<RegularTaskInfo, MAX_REGULAR_TASKS> _regularTasks;
+  FixedVector<TimedTaskInfo, MAX_TIMED_TASKS> _timedTasks;
+  FixedVector<SignalTaskInfo, MAX_SIGNAL_TASKS> _signalTasks;
+  // Filters of the signal tasks by slot
+  SignalIndex<MAX_TASKS> _signalIndex;
+  // Slots of the signal tasks with execute set, only these are visited
+  FixedVector<uint16_t, MAX_SIGNAL_TASKS> _readySignalTasks;
+  // Filters timed tasks wait for, by slot
+  SignalIndex<MAX_TASKS> _signalWaiters;
+
+  // Task table, a slot keeps its position while the pools are reordered
+  TaskSlot _slots[MAX_TASKS];
+  uint16_t _freeSlot;
+  // Handed out PIDs per kind, so the insertion into a pool cannot fail
+  uint16_t _reservedTasks[3];
+
+  // Pending executions of the timed tasks, the id is the slot of the task.
+  // It keeps the tick interrupt constant, the dispatch only touches the
+  // tasks that are due.
+  TimerQueue _timerQueue;
+  // Timed tasks that slept 0 ms while the timed tasks ran: they are queued
+  // after the pass, so they run in the next iteration instead of again now
+  bool _inTimedPass = false;
+  FixedVector<TaskPID, MAX_TIMED_TASKS> _nextIterationTasks;
+
+  // Tasks are killed at the end of the iteration
+  bool _killPending;
+
+  // Requests posted by the other core, the queue carries the index in _requests
+  Request _requests[REQUEST_QUEUE_SIZE];
+  uint32_t _freeRequests;
+  queue_t _requestQueue;
+  // Signals posted by the other core
+  queue_t _signalQueue;
+  // Protects the free lists, both cores allocate PIDs and requests
+  critical_section_t _lock;
+  // Signals triggered on this core (also from interrupts), not matched yet
+  SignalRing<PENDING_SIGNAL_COUNT> _pendingSignals;
+  // Signals the signal queue of the other core had no room for
+  uint32_t _droppedForwards = 0;
 
   uint32_t _loop_statistic[8];
   uint32_t _max_loop_time;
   int _loop_statistic_ptr;
 
-  bool _running;
-  uint32_t _systickCounter = 0;
-  TaskPID _nextTaskPID = 0;
-
-  Mainloop();
-
-  void onMillisecond();
+  // Busy/idle time of the current and the last completed load window
+  uint64_t _loadWindowStart;
+  uint64_t _idleTime;
+  float _cpuLoad;
+
+  volatile bool _running;
+  // Requests from the other core are queued once the core is started
+  volatile bool _started;
+  bool _taskIdle;
+
+  uint64_t _iterationStart;
+  uint32_t _lowPriorityBudgetUs;
+  // Round robin position of the low priority tasks
+  size_t _nextLowPriorityTask;
+  uint32_t _coalescedPeriods;
+
+  Mainloop(int core);
+
+  bool isOwnCore() const { return get_core_num() == static_cast<uint>(_core); }
+  Mainloop &getTarget(int core) { return core == THIS_CORE ? *this : getInstance(core); }
+  TaskPID allocatePID(TaskKind kind);
+  void releaseSlot(uint16_t slot);
+  // Returns the slot of a task of this core, or NO_SLOT for unknown or stale PIDs
+  uint16_t findSlot(TaskPID handle) const;
+  void insertTask(TaskPID handle, size_t index);
+  void requestKill(TaskPID handle);
+  void removeTask(uint16_t slot);
+  template <typename T> void eraseTask(T &tasks, size_t index);
+  int allocateRequest();
+  void processRequests();
+  void matchSignal(Signal signal);
+  void executeSignalTasks(bool &idle);
+  void wakeSignalWaiters(Signal signal);
+
+  bool hasPendingWork();
+  void waitForEvent(uint32_t currentTime);
+  void updateLoad(uint64_t now);
+  void executeTimedTasks();
+  bool executeRegularTask(size_t index);
+  bool executeRegularTasks(uint32_t currentTime, bool &idle);
+  void scheduleTimedTask(size_t index, uint32_t nextExecution);
   void calculateStatistics(struct TaskInfo &task);
-  void OuptutTaskInformation(const struct TaskInfo &task) const;
-
-  static bool alarm_callback(repeating_timer *rt);
-};
\ No newline at end of file
+  void OuptutTaskInformation(std::ostream &out, const struct TaskInfo &task) const;
+};
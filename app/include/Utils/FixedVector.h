@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// Vector with a capacity fixed at compile time, the elements are stored inside
+// the object and nothing is allocated. push_back() on a full vector returns
+// false.
+template <typename T, size_t Capacity>
+class FixedVector {
+public:
+  FixedVector() = default;
+  FixedVector(const FixedVector &) = delete;
+  FixedVector &operator=(const FixedVector &) = delete;
+  ~FixedVector() { clear(); }
+
+  bool push_back(const T &value) {
+    if (_size == Capacity) {
+      return false;
+    }
+    new (&_storage[_size * sizeof(T)]) T(value);
+    _size++;
+    return true;
+  }
+
+  bool push_back(T &&value) {
+    if (_size == Capacity) {
+      return false;
+    }
+    new (&_storage[_size * sizeof(T)]) T(std::move(value));
+    _size++;
+    return true;
+  }
+
+  void pop_back() {
+    _size--;
+    data()[_size].~T();
+  }
+
+  void clear() {
+    while (_size > 0) {
+      pop_back();
+    }
+  }
+
+  T &operator[](size_t index) { return data()[index]; }
+  const T &operator[](size_t index) const { return data()[index]; }
+  T &back() { return data()[_size - 1]; }
+
+  T *begin() { return data(); }
+  T *end() { return data() + _size; }
+  const T *begin() const { return data(); }
+  const T *end() const { return data() + _size; }
+
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  bool full() const { return _size == Capacity; }
+  static constexpr size_t capacity() { return Capacity; }
+
+private:
+  alignas(T) unsigned char _storage[Capacity * sizeof(T)];
+  size_t _size = 0;
+
+  T *data() { return std::launder(reinterpret_cast<T *>(_storage)); }
+  const T *data() const { return std::launder(reinterpret_cast<const T *>(_storage)); }
+};
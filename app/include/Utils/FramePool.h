@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pico/sync.h"
+
+// Fixed number of equally sized blocks, shared by both cores.
+// allocate() returns nullptr when the request is larger than a block or all
+// blocks are in use, nothing falls back to the heap.
+template <size_t BlockSize, size_t BlockCount>
+class FramePool {
+  static_assert(BlockCount <= 32, "the free blocks are tracked in a 32 bit mask");
+  static_assert(BlockSize % alignof(std::max_align_t) == 0, "every block has to be aligned");
+
+public:
+  FramePool() {
+    critical_section_init(&_lock);
+    _free = (BlockCount == 32) ? 0xFFFFFFFF : ((1u << BlockCount) - 1);
+  }
+
+  void *allocate(size_t size) {
+    if (size > BlockSize) {
+      return nullptr;
+    }
+    critical_section_enter_blocking(&_lock);
+    void *block = nullptr;
+    if (_free != 0) {
+      int index = __builtin_ctz(_free);
+      _free &= ~(1u << index);
+      block = _blocks[index];
+    }
+    critical_section_exit(&_lock);
+    return block;
+  }
+
+  void release(void *block) {
+    size_t index = (static_cast<unsigned char *>(block) - &_blocks[0][0]) / BlockSize;
+    critical_section_enter_blocking(&_lock);
+    _free |= 1u << index;
+    critical_section_exit(&_lock);
+  }
+
+  size_t used() const { return BlockCount - __builtin_popcount(_free); }
+  static constexpr size_t capacity() { return BlockCount; }
+  static constexpr size_t blockSize() { return BlockSize; }
+
+private:
+  alignas(std::max_align_t) unsigned char _blocks[BlockCount][BlockSize];
+  uint32_t _free;
+  critical_section_t _lock;
+};
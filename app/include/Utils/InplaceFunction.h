@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Callable like std::function, but the target is always stored inside the
+// object. A target that does not fit into Capacity bytes fails to compile
+// instead of being moved to the heap.
+template <typename Signature, size_t Capacity>
+class InplaceFunction;
+
+template <typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+public:
+  InplaceFunction() = default;
+  InplaceFunction(std::nullptr_t) {}
+
+  template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InplaceFunction>>>
+  InplaceFunction(F &&func) {
+    using Target = std::decay_t<F>;
+    static_assert(sizeof(Target) <= Capacity, "Callable does not fit into the InplaceFunction, increase the capacity");
+    static_assert(alignof(Target) <= alignof(std::max_align_t), "Callable is over-aligned");
+    new (_storage) Target(std::forward<F>(func));
+    _ops = &Operations<Target>::table;
+  }
+
+  InplaceFunction(const InplaceFunction &other) {
+    if (other._ops != nullptr) {
+      other._ops->copy(_storage, other._storage);
+      _ops = other._ops;
+    }
+  }
+
+  InplaceFunction(InplaceFunction &&other) noexcept {
+    if (other._ops != nullptr) {
+      other._ops->move(_storage, other._storage);
+      _ops = other._ops;
+    }
+  }
+
+  ~InplaceFunction() { reset(); }
+
+  InplaceFunction &operator=(const InplaceFunction &other) {
+    if (this != &other) {
+      reset();
+      if (other._ops != nullptr) {
+        other._ops->copy(_storage, other._storage);
+        _ops = other._ops;
+      }
+    }
+    return *this;
+  }
+
+  InplaceFunction &operator=(InplaceFunction &&other) noexcept {
+    if (this != &other) {
+      reset();
+      if (other._ops != nullptr) {
+        other._ops->move(_storage, other._storage);
+        _ops = other._ops;
+      }
+    }
+    return *this;
+  }
+
+  R operator()(Args... args) const { return _ops->invoke(_storage, std::forward<Args>(args)...); }
+
+  explicit operator bool() const { return _ops != nullptr; }
+
+  void reset() {
+    if (_ops != nullptr) {
+      _ops->destroy(_storage);
+      _ops = nullptr;
+    }
+  }
+
+private:
+  struct OperationTable {
+    R (*invoke)(void *target, Args &&...args);
+    void (*copy)(void *destination, const void *source);
+    void (*move)(void *destination, void *source);
+    void (*destroy)(void *target);
+  };
+
+  template <typename Target>
+  struct Operations {
+    static R invoke(void *target, Args &&...args) { return (*static_cast<Target *>(target))(std::forward<Args>(args)...); }
+    static void copy(void *destination, const void *source) { new (destination) Target(*static_cast<const Target *>(source)); }
+    static void move(void *destination, void *source) {
+      new (destination) Target(std::move(*static_cast<Target *>(source)));
+      static_cast<Target *>(source)->~Target();
+    }
+    static void destroy(void *target) { static_cast<Target *>(target)->~Target(); }
+
+    static constexpr OperationTable table = {invoke, copy, move, destroy};
+  };
+
+  alignas(std::max_align_t) mutable unsigned char _storage[Capacity];
+  const OperationTable *_ops = nullptr;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Histogram of durations in us with logarithmic buckets.
+// Bucket 0 counts 0 us, bucket n counts [2^(n-1), 2^n) us and the last bucket
+// everything above. Percentiles are reported as the upper bound of the bucket,
+// limited to the exact maximum.
+class LatencyHistogram {
+public:
+  static constexpr int BUCKET_COUNT = 22; // last bucket starts at ~1 s
+
+  LatencyHistogram() { reset(); }
+
+  void add(uint32_t us) {
+    int bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+    if (bucket >= BUCKET_COUNT) {
+      bucket = BUCKET_COUNT - 1;
+    }
+    _buckets[bucket]++;
+    _count++;
+    if (us > _max) {
+      _max = us;
+    }
+  }
+
+  // percent in 1..100
+  uint32_t percentile(uint32_t percent) const {
+    if (_count == 0) {
+      return 0;
+    }
+    uint64_t threshold = (static_cast<uint64_t>(_count) * percent + 99) / 100;
+    uint64_t sum = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+      sum += _buckets[i];
+      if (sum >= threshold) {
+        uint32_t upper = i == 0 ? 0 : (1u << i) - 1;
+        return (i == BUCKET_COUNT - 1 || upper > _max) ? _max : upper;
+      }
+    }
+    return _max;
+  }
+
+  uint32_t count() const { return _count; }
+  uint32_t max() const { return _max; }
+
+  void reset() {
+    memset(_buckets, 0, sizeof(_buckets));
+    _count = 0;
+    _max = 0;
+  }
+
+private:
+  uint32_t _buckets[BUCKET_COUNT];
+  uint32_t _count;
+  uint32_t _max;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include "pico/stdlib.h"
+
+#ifndef PROFILER_PCS
+#define PROFILER_PCS 512
+#endif
+
+// Statistical profiler: a hardware alarm interrupts one core at a fixed rate
+// and counts the program counter stacked in the exception frame. Code that
+// runs with the interrupts disabled is not sampled, interrupts of a lower
+// priority are. "profile dump" prints the histogram,
+// Helper-Tools/Profiler/symbolize.py maps the addresses to functions.
+class Profiler {
+public:
+  static constexpr uint32_t PC_COUNT = PROFILER_PCS;
+  static_assert((PC_COUNT & (PC_COUNT - 1)) == 0, "PROFILER_PCS must be a power of two");
+
+  // Starts sampling the calling core, clears the previous histogram.
+  // Fails when the profiler is running or no hardware alarm is free.
+  static bool start(uint32_t rateHz);
+  static void stop();
+  static bool isRunning() { return _alarm >= 0; }
+
+  static uint32_t rate() { return _rateHz; }
+  static int core() { return _core; }
+  static uint32_t samples() { return _samples; }
+  // Samples whose PC did not fit into the histogram anymore
+  static uint32_t dropped() { return _dropped; }
+
+  // Prints the histogram, sampling is paused meanwhile
+  static void dump();
+
+  // Called by the interrupt with the exception frame of the interrupted code
+  static void sample(const uint32_t *frame);
+
+private:
+  struct Entry {
+    uint32_t pc;
+    uint32_t count;
+  };
+
+  static void clear();
+
+  static Entry _entries[PC_COUNT];
+  static volatile int _alarm;
+  static volatile bool _paused;
+  static uint32_t _periodUs;
+  static uint32_t _rateHz;
+  static int _core;
+  static volatile uint32_t _samples;
+  static volatile uint32_t _dropped;
+};
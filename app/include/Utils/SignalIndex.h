@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Utils/Signal.h"
+
+// Maps signals to the ids of the filters that match them.
+// Filters with a full mask are kept in hash buckets, so an exact match only
+// looks at the filters with the same hash. Only filters with wildcards (e.g.
+// "gp*") are compared one by one.
+// Ids are in 0..Capacity-1, every id can be registered once.
+template <uint16_t Capacity>
+class SignalIndex {
+public:
+  static constexpr uint16_t NO_ENTRY = 0xFFFF;
+
+  SignalIndex() { clear(); }
+
+  void clear() {
+    for (uint16_t i = 0; i < BUCKET_COUNT; i++) {
+      _buckets[i] = NO_ENTRY;
+    }
+    _wildcardCount = 0;
+  }
+
+  void add(SignalFilter filter, uint16_t id) {
+    _filters[id] = filter;
+    if (filter.mask == 0xFFFFFFFF) {
+      uint16_t &head = _buckets[bucket(filter.signal)];
+      _next[id] = head;
+      head = id;
+    } else {
+      _next[id] = _wildcardCount;
+      _wildcards[_wildcardCount++] = id;
+    }
+  }
+
+  void remove(uint16_t id) {
+    if (_filters[id].mask == 0xFFFFFFFF) {
+      uint16_t *entry = &_buckets[bucket(_filters[id].signal)];
+      while (*entry != NO_ENTRY && *entry != id) {
+        entry = &_next[*entry];
+      }
+      if (*entry == id) {
+        *entry = _next[id];
+      }
+    } else {
+      // the last wildcard takes the position of the removed one
+      uint16_t position = _next[id];
+      uint16_t last = _wildcards[--_wildcardCount];
+      _wildcards[position] = last;
+      _next[last] = position;
+    }
+  }
+
+  // Calls func(id) for every filter that matches the signal
+  template <typename F>
+  void match(Signal signal, F func) const {
+    for (uint16_t id = _buckets[bucket(signal)]; id != NO_ENTRY; id = _next[id]) {
+      if (_filters[id].signal == signal) {
+        func(id);
+      }
+    }
+    for (uint16_t i = 0; i < _wildcardCount; i++) {
+      uint16_t id = _wildcards[i];
+      if (((signal ^ _filters[id].signal) & _filters[id].mask) == 0) {
+        func(id);
+      }
+    }
+  }
+
+  uint16_t wildcardCount() const { return _wildcardCount; }
+
+private:
+  static constexpr uint16_t bucketCount(uint16_t count) {
+    uint16_t buckets = 1;
+    while (buckets < count) {
+      buckets <<= 1;
+    }
+    return buckets;
+  }
+
+  static constexpr uint16_t BUCKET_COUNT = bucketCount(Capacity);
+
+  // Signals are mostly four characters, the multiplication mixes all of them
+  // into the top bits
+  static uint16_t bucket(Signal signal) { return ((signal * 0x9E3779B1u) >> 16) & (BUCKET_COUNT - 1); }
+
+  uint16_t _buckets[BUCKET_COUNT];
+  SignalFilter _filters[Capacity];
+  // next id in the bucket, or the position in _wildcards for wildcard filters
+  uint16_t _next[Capacity];
+  uint16_t _wildcards[Capacity];
+  uint16_t _wildcardCount;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "Utils/Signal.h"
+
+// Lock-free single producer / single consumer ring of signals.
+// push() may be called from an interrupt, pop() from the thread that owns the
+// ring. Both only touch their own index, so neither side has to wait.
+// Producers that can preempt each other (nested interrupts) have to be
+// serialized by the caller.
+template <uint32_t SIZE>
+class SignalRing {
+  static_assert((SIZE & (SIZE - 1)) == 0, "SignalRing size must be a power of two");
+
+public:
+  // A signal that is still in the ring is not queued again, the consumer
+  // matches it after this push anyway. Returns false and counts the signal as
+  // dropped when the ring is full.
+  bool push(Signal signal) {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    uint32_t tail = _tail.load(std::memory_order_acquire);
+    for (uint32_t i = tail; i != head; i++) {
+      if (_buffer[i & (SIZE - 1)] == signal) {
+        return true;
+      }
+    }
+    if (head - tail >= SIZE) {
+      _dropped = _dropped + 1;
+      return false;
+    }
+    _buffer[head & (SIZE - 1)] = signal;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(Signal &signal) {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    signal = _buffer[tail & (SIZE - 1)];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+  uint32_t dropped() const { return _dropped; }
+
+private:
+  Signal _buffer[SIZE];
+  std::atomic<uint32_t> _head{0};
+  std::atomic<uint32_t> _tail{0};
+  volatile uint32_t _dropped = 0;
+};
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Queue of (deadline, id) pairs keyed on a free running millisecond tick.
+// Deadlines are compared wrap-safe, so the queue keeps working when the
+// 32 bit tick counter overflows after ~49 days.
+//
+// Deadlines within the next SLOTS ticks sit in a timing wheel with one list
+// per tick, so push, pop and replaceTop are O(1). Later deadlines wait in a
+// min-heap and move into the wheel when they come within range.
+//
+// Entries are never removed out of order. To reschedule an id simply push a
+// new entry; the owner detects the old one as stale when it is popped (e.g. by
+// comparing the deadline with the one stored in the task).
+class TimerQueue {
+public:
+  struct Entry {
+    uint32_t deadline;
+    uint32_t id;
+  };
+
+  // Ticks covered by the wheel, longer intervals go through the heap
+  static constexpr uint32_t SLOTS = 256;
+
+  TimerQueue() { clear(); }
+
+  // Returns true when the deadline has been reached at the given tick
+  static bool isReached(uint32_t deadline, uint32_t now) {
+    return static_cast<int32_t>(now - deadline) >= 0;
+  }
+
+  void push(uint32_t deadline, uint32_t id) {
+    if (static_cast<int32_t>(deadline - _cursor) >= static_cast<int32_t>(SLOTS)) {
+      _heap.push_back({deadline, id});
+      siftUp(_heap.size() - 1);
+      return;
+    }
+    uint16_t node = _free;
+    if (node != NONE) {
+      _free = _nodes[node].next;
+      _nodes[node].entry = {deadline, id};
+    } else {
+      node = static_cast<uint16_t>(_nodes.size());
+      _nodes.push_back({{deadline, id}, NONE});
+    }
+    link(node);
+  }
+
+  // Removes and returns the entry with the earliest deadline
+  Entry pop() {
+    if (_wheelCount == 0) {
+      return popHeap();
+    }
+    uint32_t slot = nextSlot();
+    uint16_t node = _slots[slot];
+    unlink(slot);
+    _nodes[node].next = _free;
+    _free = node;
+    return _nodes[node].entry;
+  }
+
+  // Replaces the earliest entry, this is cheaper than pop() followed by push()
+  // and is used to reschedule periodic timers
+  void replaceTop(uint32_t deadline, uint32_t id) {
+    if (_wheelCount == 0 ||
+        static_cast<int32_t>(deadline - _cursor) >= static_cast<int32_t>(SLOTS)) {
+      pop();
+      push(deadline, id);
+      return;
+    }
+    uint32_t slot = nextSlot();
+    uint16_t node = _slots[slot];
+    unlink(slot);
+    _nodes[node].entry = {deadline, id};
+    link(node);
+  }
+
+  const Entry &top() const {
+    if (_wheelCount == 0) {
+      return _heap.front();
+    }
+    return _nodes[_slots[nextSlot()]].entry;
+  }
+
+  // Returns true when the earliest entry is due at the given tick. It moves
+  // the wheel up to that tick, so call it with a tick that does not go back.
+  bool isDue(uint32_t now) {
+    if (empty()) {
+      _cursor = now;
+      return false;
+    }
+    while (true) {
+      if (_slots[_cursor % SLOTS] != NONE) {
+        // entries pushed with a deadline in the past sit in the current slot
+        return isReached(_cursor, now);
+      }
+      uint32_t step = now - _cursor;
+      if (static_cast<int32_t>(step) <= 0) {
+        return false;
+      }
+      if (_wheelCount > 0) {
+        uint32_t ahead = (nextSlot() - _cursor) % SLOTS;
+        step = ahead < step ? ahead : step;
+      }
+      if (!_heap.empty()) {
+        // stop where the earliest heap entry comes within range of the wheel
+        uint32_t ahead = _heap.front().deadline - (SLOTS - 1) - _cursor;
+        step = ahead < step ? ahead : step;
+      }
+      _cursor += step;
+      while (!_heap.empty() && static_cast<int32_t>(_heap.front().deadline - _cursor) < static_cast<int32_t>(SLOTS)) {
+        Entry entry = popHeap();
+        push(entry.deadline, entry.id);
+      }
+    }
+  }
+
+  bool empty() const { return _wheelCount == 0 && _heap.empty(); }
+  size_t size() const { return _wheelCount + _heap.size(); }
+
+  void clear() {
+    for (uint16_t &slot : _slots) {
+      slot = NONE;
+    }
+    for (uint32_t &word : _occupied) {
+      word = 0;
+    }
+    _nodes.clear();
+    _free = NONE;
+    _wheelCount = 0;
+    _heap.clear();
+  }
+
+  void reserve(size_t count) {
+    _nodes.reserve(count);
+    _heap.reserve(count);
+  }
+
+private:
+  static constexpr uint16_t NONE = UINT16_MAX;
+
+  struct Node {
+    Entry entry;
+    uint16_t next;
+  };
+
+  // Head of the list per tick, the entries of a slot share the deadline
+  uint16_t _slots[SLOTS];
+  uint32_t _occupied[SLOTS / 32];
+  std::vector<Node> _nodes;
+  uint16_t _free = NONE;
+  size_t _wheelCount = 0;
+  // The tick of the current slot, the wheel holds deadlines up to _cursor + SLOTS - 1
+  uint32_t _cursor = 0;
+  std::vector<Entry> _heap;
+
+  void link(uint16_t node) {
+    uint32_t tick = _nodes[node].entry.deadline;
+    if (static_cast<int32_t>(tick - _cursor) < 0) {
+      tick = _cursor;
+    }
+    uint32_t slot = tick % SLOTS;
+    _nodes[node].next = _slots[slot];
+    _slots[slot] = node;
+    _occupied[slot / 32] |= 1u << (slot % 32);
+    _wheelCount++;
+  }
+
+  void unlink(uint32_t slot) {
+    _slots[slot] = _nodes[_slots[slot]].next;
+    if (_slots[slot] == NONE) {
+      _occupied[slot / 32] &= ~(1u << (slot % 32));
+    }
+    _wheelCount--;
+  }
+
+  // The first occupied slot from the cursor on, the wheel must not be empty
+  uint32_t nextSlot() const {
+    uint32_t slot = _cursor % SLOTS;
+    if (_slots[slot] != NONE) {
+      return slot;
+    }
+    uint32_t word = slot / 32;
+    uint32_t bits = _occupied[word] & (~0u << (slot % 32));
+    while (bits == 0) {
+      // wraps around to the part of the first word before the cursor at last
+      word = (word + 1) % (SLOTS / 32);
+      bits = _occupied[word];
+    }
+    return word * 32 + static_cast<uint32_t>(__builtin_ctz(bits));
+  }
+
+  Entry popHeap() {
+    Entry entry = _heap.front();
+    _heap.front() = _heap.back();
+    _heap.pop_back();
+    if (!_heap.empty()) {
+      siftDown(0);
+    }
+    return entry;
+  }
+
+  static bool earlier(const Entry &a, const Entry &b) {
+    return static_cast<int32_t>(a.deadline - b.deadline) < 0;
+  }
+
+  void siftUp(size_t index) {
+    Entry entry = _heap[index];
+    while (index > 0) {
+      size_t parent = (index - 1) / 2;
+      if (!earlier(entry, _heap[parent])) {
+        break;
+      }
+      _heap[index] = _heap[parent];
+      index = parent;
+    }
+    _heap[index] = entry;
+  }
+
+  void siftDown(size_t index) {
+    Entry entry = _heap[index];
+    size_t count = _heap.size();
+    while (true) {
+      size_t child = index * 2 + 1;
+      if (child >= count) {
+        break;
+      }
+      if (child + 1 < count && earlier(_heap[child + 1], _heap[child])) {
+        child++;
+      }
+      if (!earlier(_heap[child], entry)) {
+        break;
+      }
+      _heap[index] = _heap[child];
+      index = child;
+    }
+    _heap[index] = entry;
+  }
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "hardware/sync.h"
+#include "pico/stdlib.h"
+
+#ifndef TRACE_EVENTS_PER_CORE
+#define TRACE_EVENTS_PER_CORE 512
+#endif
+
+// Ring of timestamped binary events per core, the oldest events are
+// overwritten. record() only masks the interrupts for the index update and
+// is safe in interrupts. "trace dump" prints the rings, Helper-Tools/TraceViewer
+// converts the dump to Chrome trace JSON.
+class Trace {
+public:
+  enum class Type : uint8_t {
+    TaskStart = 1,  // arg: PID
+    TaskEnd,        // arg: PID
+    Signal,         // arg: signal
+    IrqEnter,       // arg: IRQ number
+    DmaStart,       // arg: channel
+    DmaComplete,    // arg: channel
+    FlashProgram,   // arg: flash offset, until FlashDone
+    FlashErase,     // arg: flash offset, until FlashDone
+    FlashDone       // arg: flash offset
+  };
+
+  // 12 bytes, the layout is part of the dump format
+  struct Event {
+    uint32_t time; // us since boot, lower 32 bits
+    uint32_t arg;
+    uint8_t type;
+    uint8_t reserved[3];
+  };
+
+  static_assert(sizeof(Event) == 12, "Event layout changed");
+
+  static constexpr uint32_t EVENT_COUNT = TRACE_EVENTS_PER_CORE;
+  static_assert((EVENT_COUNT & (EVENT_COUNT - 1)) == 0, "TRACE_EVENTS_PER_CORE must be a power of two");
+
+  static void record(Type type, uint32_t arg) {
+    if (!_enabled) {
+      return;
+    }
+    Ring &ring = _rings[get_core_num()];
+    uint32_t interrupts = save_and_disable_interrupts();
+    Event &event = ring.events[ring.head & (EVENT_COUNT - 1)];
+    ring.head = ring.head + 1;
+    event.time = time_us_32();
+    event.arg = arg;
+    event.type = static_cast<uint8_t>(type);
+    restore_interrupts(interrupts);
+  }
+
+  // Records the number of the running interrupt
+  static void recordIrq() { record(Type::IrqEnter, __get_current_exception() - 16); }
+
+  static void enable(bool enabled) { _enabled = enabled; }
+  static bool isEnabled() { return _enabled; }
+  static void clear();
+
+  // Number of events recorded on the core since the last clear()
+  static uint32_t recorded(int core) { return _rings[core].head; }
+
+  // Prints the ring of the core, recording is paused meanwhile
+  static void dump(int core);
+
+private:
+  struct Ring {
+    Event events[EVENT_COUNT];
+    volatile uint32_t head;
+  };
+
+  static Ring _rings[2];
+  static volatile bool _enabled;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "VariableStore/IVariable.h"
+
+// Integer variable that reads its value from the owner on every access, e.g.
+// counters of a device. It cannot be set.
+class ReadOnlyValue : public IVariable {
+public:
+  using Getter = std::function<int()>;
+
+  ReadOnlyValue(const std::string &name, Getter getter) : IVariable(name), _getter(std::move(getter)) {
+    setSystemVariable();
+  }
+
+  std::string asString() const override { return std::to_string(_getter()); }
+  float asFloat() const override { return static_cast<float>(_getter()); }
+  int asInt() const override { return _getter(); }
+  bool asBool() const override { return _getter() != 0; }
+
+  bool set(const std::string &value) override { return false; }
+  bool set(float value) override { return false; }
+  bool set(int value) override { return false; }
+  bool setBool(bool value) override { return false; }
+
+  Type getType() const override { return Type::INT; }
+
+private:
+  Getter _getter;
+};
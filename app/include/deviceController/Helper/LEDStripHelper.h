@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Config.h"
+#include "Mainloop.h"
+#include "deviceController/DeviceRepository.h"
+#include "devices/ILEDStrip.h"
+#include "devices/LEDGroup.h"
+#include "devices/WS2812.h"
+#include "devices/WS2812Parallel.h"
+#include "VariableStore/VariableStore.h"
+#include "VariableStore/SpecialVariables/ReadOnlyValue.h"
+#include "Utils/ValueConverter.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+class LEDStripHelper {
+public:
+    static std::shared_ptr<ILEDStrip> findLEDStrip(const std::string& name, DeviceRepository& deviceRepo) {
+        auto ws2812_device = deviceRepo.getDevice<WS2812>("WS2812", name);
+        if (ws2812_device) {
+            return ws2812_device;
+        }
+        auto parallel_device = deviceRepo.getDevice<WS2812Parallel>("WS2812P", name);
+        if (parallel_device) {
+            return parallel_device;
+        }
+        return deviceRepo.getDevice<LEDGroup>("LEDGroup", name);
+    }
+
+    // <name>.brightness, .gamma, .balance and .order control the color LUT of the strip
+    static bool setupOutputVariables(std::shared_ptr<ILEDStrip> device) {
+        auto& variableStore = VariableStore::getInstance();
+        ColorLUT& lut = device->getColorLUT();
+
+        variableStore.addVariable(device->getName() + ".brightness", static_cast<int>(lut.getBrightness()))->setSystemVariable();
+        variableStore.registerCallback(device->getName() + ".brightness", [device](const std::string& key, const std::string& value) {
+            int brightness = ValueConverter::toInt(value);
+            if (brightness < 0 || brightness > 255) {
+                return false;
+            }
+            device->getColorLUT().setBrightness(brightness);
+            return true;
+        });
+
+        variableStore.addVariable(device->getName() + ".gamma", lut.getGamma())->setSystemVariable();
+        variableStore.registerCallback(device->getName() + ".gamma", [device](const std::string& key, const std::string& value) {
+            return device->getColorLUT().setGamma(std::strtof(value.c_str(), nullptr));
+        });
+
+        variableStore.addVariable(device->getName() + ".balance", lut.getBalance())->setSystemVariable();
+        variableStore.registerCallback(device->getName() + ".balance", [device](const std::string& key, const std::string& value) {
+            device->getColorLUT().setBalance(ValueConverter::toUInt(value));
+            return true;
+        });
+
+        variableStore.addVariable(device->getName() + ".order", lut.getOrder())->setSystemVariable();
+        variableStore.registerCallback(device->getName() + ".order", [device](const std::string& key, const std::string& value) {
+            return device->getColorLUT().setOrder(value);
+        });
+
+        return true;
+    }
+
+    // <name>.fps is the frame rate the strip sustains, <name>.dropped counts the
+    // frames replaced before they were sent, <name>.coalesced the frames a
+    // playback skipped to keep its speed
+    static bool setupFrameVariables(std::shared_ptr<ILEDStrip> device) {
+        auto& variableStore = VariableStore::getInstance();
+        variableStore.registerVariable(std::make_shared<ReadOnlyValue>(device->getName() + ".fps", [device]() {
+            return static_cast<int>(device->getFrameGovernor().getMaxFrameRate());
+        }));
+        variableStore.registerVariable(std::make_shared<ReadOnlyValue>(device->getName() + ".dropped", [device]() {
+            return static_cast<int>(device->getFrameGovernor().getDropped());
+        }));
+        variableStore.registerVariable(std::make_shared<ReadOnlyValue>(device->getName() + ".coalesced", [device]() {
+            return static_cast<int>(device->getFrameGovernor().getCoalesced());
+        }));
+        return true;
+    }
+
+    // <name>.budget is the current budget in mA (0: off), <name>.channel_ma the
+    // current of one channel at full brightness. <name>.current is the
+    // estimated current of the last frame before it was limited, in mA,
+    // <name>.clipped counts the frames that were scaled down.
+    static bool setupPowerVariables(std::shared_ptr<WS2812> device) {
+        auto& variableStore = VariableStore::getInstance();
+        PowerLimiter& power = device->getPowerLimiter();
+
+        variableStore.addVariable(device->getName() + ".budget", static_cast<int>(power.getBudget()))->setSystemVariable();
+        variableStore.registerCallback(device->getName() + ".budget", [device](const std::string& key, const std::string& value) {
+            int budget = ValueConverter::toInt(value);
+            if (budget < 0) {
+                return false;
+            }
+            device->getPowerLimiter().setBudget(budget);
+            return true;
+        });
+
+        variableStore.addVariable(device->getName() + ".channel_ma", static_cast<int>(power.getChannelMilliamps()))->setSystemVariable();
+        variableStore.registerCallback(device->getName() + ".channel_ma", [device](const std::string& key, const std::string& value) {
+            int channel_ma = ValueConverter::toInt(value);
+            if (channel_ma <= 0) {
+                return false;
+            }
+            device->getPowerLimiter().setChannelMilliamps(channel_ma);
+            return true;
+        });
+
+        variableStore.registerVariable(std::make_shared<ReadOnlyValue>(device->getName() + ".current", [device]() {
+            return static_cast<int>(device->getPowerLimiter().getCurrent());
+        }));
+        variableStore.registerVariable(std::make_shared<ReadOnlyValue>(device->getName() + ".clipped", [device]() {
+            return static_cast<int>(device->getPowerLimiter().getClipped());
+        }));
+        return true;
+    }
+
+    // <name>.dither switches the temporal dithering of the strip
+    static bool setupDitherVariable(std::shared_ptr<WS2812> device) {
+        auto& variableStore = VariableStore::getInstance();
+        variableStore.addBoolVariable(device->getName() + ".dither", false)->setSystemVariable();
+        variableStore.registerCallback(device->getName() + ".dither", [device](const std::string& key, const std::string& value) {
+            bool enabled = value == "true" || value == "1";
+            // the dither task runs on the render core
+            Mainloop::getInstance(LED_RENDER_CORE).invoke([device, enabled]() {
+                if (!device->setDithering(enabled)) {
+                    std::cout << "Failed to switch dithering of " << device->getName() << std::endl;
+                }
+            });
+            return true;
+        });
+        return true;
+    }
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "deviceController/DeviceRepository.h"
+#include "deviceController/Helper/LEDStripHelper.h"
 #include "devices/PIODevice.h"
 #include "devices/WS2812.h"
 
@@ -66,6 +67,10 @@ public:
             std::cout << "Failed to assign PIO device to LED device: " << device_name << std::endl;
             return nullptr;
         }
+        LEDStripHelper::setupOutputVariables(led_device);
+        LEDStripHelper::setupFrameVariables(led_device);
+        LEDStripHelper::setupDitherVariable(led_device);
+        LEDStripHelper::setupPowerVariables(led_device);
         return led_device;
     }
 
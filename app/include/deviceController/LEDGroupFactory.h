@@ -0,0 +1,89 @@
+#pragma once
+
+#include "deviceController/DeviceRepository.h"
+#include "deviceController/Helper/LEDStripHelper.h"
+#include "devices/LEDGroup.h"
+#include "devices/WS2812.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <iostream>
+
+class LEDGroupFactory : public IDeviceFactory {
+public:
+    LEDGroupFactory(DeviceRepository& deviceRepo) : _deviceRepo(deviceRepo) {}
+
+    const Category getCategory() const override { return Category::Communication; }
+    const std::vector<std::string> getDeviceNames() const override {
+        static std::vector<std::string> names = {"LEDGroup"};
+        return names;
+    }
+    const std::string& getParameterInfo() const override{
+        static std::string empty = "<WS2812DeviceNames> [name]\n"
+                                   "  WS2812DeviceNames: Comma separated names of the WS2812 devices (e.g.: WS2812-0,WS2812-1),\n"
+                                   "                     their frames are started together. A frame of the group holds the\n"
+                                   "                     frames of the strips in this order.\n"
+                                   "  name:              Optional unique name for the device (default: auto-generated)\n\n"
+                                   "  Signal lg<NN> (NN: number of the group, e.g. lg00) is triggered when a frame of the group was sent";
+        return empty;
+    }
+    std::shared_ptr<IDevice> createDevice(const std::string& name, const std::vector<std::string>& params) override {
+        if (params.size() < 1 || _number >= MAX_GROUPS) {
+            return nullptr;
+        }
+        std::vector<std::shared_ptr<WS2812>> strips;
+        std::stringstream names(params[0]);
+        std::string strip_name;
+        while (std::getline(names, strip_name, ',')) {
+            auto ws2812_device = _deviceRepo.getDevice<WS2812>("WS2812", strip_name);
+            if (!ws2812_device || ws2812_device->getStatus() != IDevice::DeviceStatus::Initialized) {
+                std::cout << "Invalid WS2812 device: " << strip_name << std::endl;
+                return nullptr;
+            }
+            if (std::find(strips.begin(), strips.end(), ws2812_device) != strips.end()) {
+                std::cout << "WS2812 device listed twice: " << strip_name << std::endl;
+                return nullptr;
+            }
+            strips.push_back(ws2812_device);
+        }
+        if (strips.empty() || strips.size() > MAX_STRIPS) {
+            std::cout << "A group needs 1 - " << MAX_STRIPS << " WS2812 devices" << std::endl;
+            return nullptr;
+        }
+        std::string device_name;
+        if (params.size() >= 2) {
+            device_name = params[1];
+        } else {
+            device_name = "LEDGroup-" + std::to_string(_number);
+        }
+        // "lg" and the two digits of the group number
+        Signal signal = 0x6C673030 + ((_number / 10) << 8) + (_number % 10);
+        _number++;
+
+        auto group_device = std::make_shared<LEDGroup>(strips, signal, device_name);
+        if (group_device->getStatus() != IDevice::DeviceStatus::Initialized) {
+            std::cout << "Failed to initialize LED group: " << device_name << std::endl;
+            return nullptr;
+        }
+        for (auto& strip : strips) {
+            if (!strip->assignToUser(group_device)) {
+                std::cout << "Failed to assign " << strip->getName() << " to LED group: " << device_name << std::endl;
+                return nullptr;
+            }
+        }
+        LEDStripHelper::setupFrameVariables(group_device);
+        return group_device;
+    }
+
+private:
+    DeviceRepository& _deviceRepo;
+    uint8_t _number = 0;
+
+    static constexpr uint8_t MAX_GROUPS = 100;
+    static constexpr size_t MAX_STRIPS = 32;
+};
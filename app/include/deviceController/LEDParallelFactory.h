@@ -0,0 +1,80 @@
+#pragma once
+
+#include "deviceController/DeviceRepository.h"
+#include "deviceController/Helper/LEDStripHelper.h"
+#include "devices/PIODevice.h"
+#include "devices/WS2812Parallel.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <iostream>
+
+class LEDParallelFactory : public IDeviceFactory {
+public:
+    LEDParallelFactory(DeviceRepository& deviceRepo) : _deviceRepo(deviceRepo) {}
+
+    const Category getCategory() const override { return Category::Communication; }
+    const std::vector<std::string> getDeviceNames() const override {
+        static std::vector<std::string> names = {"WS2812P"};
+        return names;
+    }
+    const std::string& getParameterInfo() const override{
+        static std::string empty = "<PIODeviceName> <first_pin> <strips> <num_leds> [bits_per_pixel] [frequency] [name]\n"
+                                   "  PIODeviceName:  Name of the PIO device to use (e.g.: PIO0.SM0)\n"
+                                   "  first_pin:      First of the consecutive pins of the strips\n"
+                                   "  strips:         Number of strips (1 - 16), all driven by one state machine\n"
+                                   "  num_leds:       Number of LEDs per strip\n"
+                                   "  bits_per_pixel: Number of bits per pixel, typically 24 for RGB or 32 for RGBW (default: 24)\n"
+                                   "  frequency:      Signal frequency in Hz, typically 800000 for WS2812 (default: 800000)\n"
+                                   "  name:           Optional unique name for the device (default: auto-generated)";
+        return empty;
+    }
+    std::shared_ptr<IDevice> createDevice(const std::string& name, const std::vector<std::string>& params) override {
+        if (params.size() < 4) {
+            return nullptr;
+        }
+        std::string pio_device_name = params[0];
+        auto pio_device = _deviceRepo.getDevice<PIODevice>("PIO", pio_device_name);
+        if (!pio_device || pio_device->getStatus() != IDevice::DeviceStatus::Initialized) {
+            std::cout << "Invalid PIO device: " << pio_device_name << std::endl;
+            return nullptr;
+        }
+        int first_pin = std::strtol(params[1].c_str(), nullptr, 0);
+        int strips = std::strtol(params[2].c_str(), nullptr, 0);
+        int num_leds = std::strtol(params[3].c_str(), nullptr, 0);
+        int bits_per_pixel = 24;
+        float frequency = 800000;
+        if (params.size() >= 5) {
+            bits_per_pixel = std::strtol(params[4].c_str(), nullptr, 0);
+        }
+        if (params.size() >= 6) {
+            frequency = std::strtof(params[5].c_str(), nullptr);
+        }
+        std::string device_name;
+        if (params.size() >= 7) {
+            device_name = params[6];
+        }else{
+            device_name = "WS2812P-" + std::to_string(_number);
+        }
+        _number++;
+        auto led_device = std::make_shared<WS2812Parallel>(pio_device, first_pin, strips, num_leds, bits_per_pixel, frequency, device_name);
+        if (led_device->getStatus() != IDevice::DeviceStatus::Initialized) {
+            std::cout << "Failed to initialize LED device: " << device_name << std::endl;
+            return nullptr;
+        }
+        if(!pio_device->assignToUser(led_device)){
+            std::cout << "Failed to assign PIO device to LED device: " << device_name << std::endl;
+            return nullptr;
+        }
+        LEDStripHelper::setupOutputVariables(led_device);
+        LEDStripHelper::setupFrameVariables(led_device);
+        return led_device;
+    }
+
+private:
+    DeviceRepository& _deviceRepo;
+    uint8_t _number = 0;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "hardware/dma.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Scatter-gather DMA. A control channel walks a list of segments and loads
+// each of them into the data channel (transfer count and read address, the
+// write of the read address starts it). The data channel chains back to the
+// control channel when a segment is done. The list ends with an empty
+// segment: its null trigger stops the chain and raises the interrupt of the
+// data channel (IRQ quiet), so the transfer done handling of the device sees
+// one interrupt per list. A transfer can be put together from pieces in
+// different places (flash, RAM) without copying them.
+class DMAChain {
+public:
+  // Layout of the alias 3 registers of the data channel that are written
+  struct Segment {
+    uint32_t count; // transfers of the data size of the data channel
+    const void* data;
+  };
+
+  // data_channel: configured channel of the device (read increment, dreq and
+  // write address), it is switched to the chain until the object is deleted
+  DMAChain(uint data_channel, size_t max_segments);
+  ~DMAChain();
+
+  // false if there was no free channel for the control channel
+  bool isValid() const { return _control >= 0; }
+  int getControlChannel() const { return _control; }
+  size_t getMaxSegments() const { return _segments.size() - 1; }
+
+  // The list must not be changed while it is sent
+  void clear();
+  // false if the list is full, empty segments are skipped
+  bool add(const void* data, uint32_t count);
+  bool set(const Segment* segments, size_t count);
+
+  // Sends the list, false if the previous one is still sent
+  bool start();
+  // Sets up the list without starting it. Returns the bit of the control
+  // channel for dma_start_channel_mask(), or 0 if the previous list is still
+  // sent.
+  uint32_t prepare();
+  bool isBusy() const;
+
+private:
+  uint _data;
+  int _control;
+  std::vector<Segment> _segments; // terminated by an empty segment
+  size_t _used = 0;
+};
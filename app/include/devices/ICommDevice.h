@@ -15,7 +15,9 @@ public:
 
     virtual int dataAvailable() = 0;
     virtual int receive(uint8_t* buffer, size_t length) = 0;
+    // false if a callback is registered already or no signal task is free
     virtual bool registerDataReceivedCallback(Mainloop::Function func, uint32_t signal = 0) = 0;
+    virtual void unregisterDataReceivedCallback() = 0;
 
     virtual int getBufferSize() const = 0;
 };
\ No newline at end of file
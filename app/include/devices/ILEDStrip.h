@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "LED/ColorLUT.h"
+#include "LED/FrameGovernor.h"
+
+// Frame output of the LED strip devices (WS2812, WS2812Parallel), used by
+// the pattern playback
+class ILEDStrip {
+public:
+  virtual ~ILEDStrip() = default;
+
+  virtual const std::string getName() const = 0;
+
+  // Pixels of one frame
+  virtual size_t getLEDCount() const = 0;
+  // Copies and queues a frame, false if count < getLEDCount()
+  virtual bool setPattern(const uint32_t* data, size_t count) = 0;
+  // The same for packed pixels, 3 bytes per LED in the order they are sent
+  // (PackedPixel)
+  virtual bool setPackedPattern(const uint8_t* data, size_t count) = 0;
+  // A queued frame waits for the previous one to finish
+  virtual bool isFramePending() const = 0;
+
+  // Applied to every pixel as it is written into a frame
+  virtual ColorLUT& getColorLUT() = 0;
+  // Frame time and frame counters of the strip
+  virtual FrameGovernor& getFrameGovernor() = 0;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "devices/IDevice.h"
+#include "devices/ILEDStrip.h"
+#include "devices/WS2812.h"
+#include "Utils/Signal.h"
+
+#include "pico/sync.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// WS2812 strips that latch their frames together. The frame buffers of the
+// members are held (PIOFrameBuffer::setGroup()): a frame of the group starts
+// when every member has a frame queued and its latch time is over, then the
+// DMA channels of all members are started in the same cycle with one write of
+// the multi channel trigger. Members fed from the FIFO interrupt (short
+// strips) follow a few microseconds later. When the last member finished its
+// frame the group triggers getSignal() ("lg" and the two digits of the group
+// number) on the mainloop.
+class LEDGroup : public ICreateSharedFromThis<LEDGroup>, public IDevice, public ILEDStrip {
+public:
+  LEDGroup(std::vector<std::shared_ptr<WS2812>> strips, Signal signal, const std::string& name = "LEDGroup");
+  ~LEDGroup();
+
+  const std::string getName() const override { return _name; }
+  const std::string getType() const override { return "LEDGroup"; }
+  const std::string getDetails() const override;
+
+  /// One frame holds the frames of the members one after the other, in the
+  /// order of the group. Every member gets its frame, the group starts once
+  /// all of them are queued.
+  /// returns false if count is less than getLEDCount()
+  bool setPattern(const uint32_t* data, size_t count) override;
+  bool setPackedPattern(const uint8_t* data, size_t count) override;
+
+  // Pixels of all members
+  size_t getLEDCount() const override { return _num_leds; }
+  bool isFramePending() const override;
+  // The members keep their own LUTs (<member>.brightness, ...), this is the
+  // LUT of the first member
+  ColorLUT& getColorLUT() override { return _strips.front()->getColorLUT(); }
+  // Paced by the slowest member
+  FrameGovernor& getFrameGovernor() override { return _governor; }
+
+  const std::vector<std::shared_ptr<WS2812>>& getStrips() const { return _strips; }
+  Signal getSignal() const { return _signal; }
+  // Frames of the group sent by all members
+  uint32_t getFrameCount() const { return _framesSent; }
+
+private:
+  std::vector<std::shared_ptr<WS2812>> _strips;
+  Signal _signal;
+  std::string _name;
+  size_t _num_leds = 0;
+
+  FrameGovernor _governor{0};
+  critical_section_t _lock;
+  uint32_t _sending = 0; // members still sending the frame of the group, under _lock
+  uint32_t _framesSent = 0;
+
+  void memberReady();
+  void memberDone();
+};
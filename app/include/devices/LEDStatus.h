@@ -36,6 +36,4 @@ private:
         {"Error", 0x03000000},    // Red
         {"Idle", 0x00000300},     // Blue
     };
-
-    std::vector<uint32_t> _led_colors;
 };
\ No newline at end of file
@@ -2,7 +2,9 @@
 
 #include "hardware/pio.h"
 #include "hardware/dma.h"
+#include "devices/DMAChain.h"
 #include "devices/IDevice.h"
+#include "Utils/InplaceFunction.h"
 
 #include <vector>
 #include <memory>
@@ -23,11 +25,46 @@ public:
     bool useDMA32(uint transfer_count);
     bool useDMA16(uint transfer_count);
     bool useDMA8(uint transfer_count);
+    // Transfers without DMA (short strips) refill the TX FIFO from the
+    // interrupt of the PIO (IRQ 0, on the calling core) instead of waiting
+    // for it: transfer() returns immediately and the transfer done callback
+    // is called when the last word is in the FIFO
+    bool useFifoIRQ();
+    // Scatter-gather DMA (after useDMA*): transfers are sent as a list of up
+    // to max_segments segments (DMAChain), e.g. a frame put together from
+    // pattern rows in flash and overlays in RAM without copying. Plain
+    // transfers go through the chain as one segment.
+    bool useDMAChain(size_t max_segments);
 
     // WARNING: when using DMA, make sure the data buffer remains valid until the transfer is complete
     // DMA transfer is not checked for completion in this method
     bool transfer(const std::vector<uint32_t> &data) { return transfer(data.data(), data.size()); }
     bool transfer(const uint32_t *data, size_t count);
+    // For 8 bit DMA (useDMA8) and programs shifting left with autopull at 8 bits:
+    // without DMA each byte is written into bits 31..24 of a FIFO word, the DMA
+    // replicates it into all byte lanes
+    bool transfer(const uint8_t *data, size_t count);
+    // Sets up the DMA for a transfer of count words or bytes without starting
+    // it. Returns the bit of the channel for dma_start_channel_mask() (the
+    // control channel with useDMAChain()), used to start several devices in
+    // the same cycle, or 0 if the transfer has to be started with transfer()
+    // (no DMA, other count or the DMA is busy).
+    uint32_t prepareTransfer(const void *data, size_t count);
+    // Sends the segments with the chain (useDMAChain()), without it they are
+    // written one after the other like transfer() does
+    bool transfer(const DMAChain::Segment *segments, size_t count);
+
+    // Called from the DMA interrupt (DMA_IRQ_0, on the core that set it) or the
+    // FIFO interrupt (useFifoIRQ()) when a transfer started by transfer()
+    // finished. The PIO FIFO may still hold data.
+    using TransferDoneFunction = InplaceFunction<void(), 2 * sizeof(void *)>;
+    bool setTransferDoneCallback(TransferDoneFunction callback);
+
+    bool usesDMA() const { return _dma_channel >= 0; }
+    bool usesDMAChain() const { return _chain != nullptr; }
+    // transfer() returns before the data is sent, see setTransferDoneCallback()
+    bool isAsync() const { return _dma_channel >= 0 || _fifoIRQ; }
+    bool isBusy() const;
 
     PIO getPIO() const { return _pio; }
     int getPIONumber() const { return _number; }
@@ -41,6 +78,22 @@ private:
     int _program_offset;
     int _dma_channel;
     uint _transfer_count;
+    dma_channel_transfer_size_t _transfer_size = DMA_SIZE_32;
+    std::unique_ptr<DMAChain> _chain;
+
+    TransferDoneFunction _transferDone;
+
+    bool _fifoIRQ = false;
+    const uint8_t *volatile _fifoData = nullptr; // next word or byte, nullptr when idle
+    volatile size_t _fifoRemaining = 0;
+    bool _fifoBytes = false;
 
     bool useDMA(uint transfer_count, dma_channel_transfer_size_t size);
+    bool startFifoTransfer(const void *data, size_t count, bool bytes);
+    void feedFifo();
+
+    static PIODevice *_dmaDevices[NUM_DMA_CHANNELS];
+    static void dmaIRQ();
+    static PIODevice *_fifoDevices[2][4]; // per PIO and state machine
+    static void pioIRQ();
 };
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "devices/PIODevice.h"
+
+#include "pico/sync.h"
+#include "pico/time.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Double buffered frame output of a PIO state machine, used by the WS2812
+// devices. The DMA only reads the front buffer, frames are rendered into the
+// back buffer and queued with present(). The buffers are swapped when the
+// previous frame is sent and the latch time is over, from the DMA interrupt,
+// so a frame is never changed while it is sent. The latch time is waited for
+// with an alarm of a pool shared by the buffers, every buffer reserves one
+// alarm of it when it is created.
+class PIOFrameBuffer {
+public:
+  // A frame is count transfers of transfer_bytes (4: words, 1: bytes for
+  // PIODevice::transfer(const uint8_t*, size_t)).
+  // latch_us: time between the end of the DMA transfer and the next frame
+  // (data still in the FIFO plus the reset time of the strip)
+  PIOFrameBuffer(std::shared_ptr<PIODevice> pio, size_t count, size_t transfer_bytes, uint32_t latch_us);
+  ~PIOFrameBuffer();
+
+  // false if no alarm for the latch time could be reserved (more than
+  // MAX_BUFFERS buffers or no free hardware alarm), nothing is sent then
+  bool isValid() const { return _reserved; }
+  static constexpr uint MAX_BUFFERS = 16;
+
+  // Returns the back buffer. It holds the frame before the last one, or the
+  // queued frame if it was not sent yet (then it is replaced). Nothing is sent
+  // until present() is called. The buffer is word aligned.
+  uint8_t* getBackBuffer();
+  // Queues the back buffer, it is sent as soon as the PIO is free. Returns
+  // true when it replaced a queued frame that was not sent yet.
+  bool present();
+  // A presented frame waits for the previous one to finish
+  bool isFramePending() const { return _pending; }
+
+  size_t getTransferCount() const { return _count; }
+
+  // Sends a frame straight from data (e.g. memory mapped pattern data in
+  // flash) instead of a buffer, callable from an interrupt. Returns false
+  // without sending when the PIO did not take the previous frame yet or a
+  // frame is queued. data has to stay valid until the transfer is done.
+  bool sendDirect(const void* data);
+  // The same for a frame in several pieces (PIODevice::useDMAChain())
+  bool sendDirect(const DMAChain::Segment* segments, size_t count);
+
+  // Grouped buffers (LEDGroup) do not start their frames on their own: ready()
+  // is called when the queued frame could start (thread context, DMA or alarm
+  // interrupt) and the group starts the frames of all members with arm() and
+  // send(). done() is called when a frame was sent. Both are called outside
+  // the lock of the buffer.
+  using GroupFunction = PIODevice::TransferDoneFunction;
+  void setGroup(GroupFunction ready, GroupFunction done);
+  bool isGrouped() const { return _grouped; }
+  // The queued frame of a grouped buffer can start now
+  bool isReady() const;
+  // Makes the queued frame the front buffer and prepares its transfer. Returns
+  // the bit of the DMA channel to start (dma_start_channel_mask()), or 0 if
+  // the frame is started with send().
+  uint32_t arm();
+  void send();
+
+private:
+  std::shared_ptr<PIODevice> _pio;
+  size_t _count;
+  size_t _transferBytes;
+  uint32_t _latchUs;
+
+  std::vector<uint32_t> _frames[2]; // words for the alignment
+  uint8_t _front = 0;
+  volatile bool _pending = false;   // back buffer presented, not sent yet
+  volatile bool _rendering = false; // back buffer handed out by getBackBuffer()
+  volatile bool _sending = false;   // front buffer is being sent
+  volatile bool _waiting = false;   // alarm for the end of the latch time is set
+  uint64_t _readyAt = 0;            // time the PIO takes the next frame
+  volatile bool _grouped = false;
+  GroupFunction _groupReady;
+  GroupFunction _groupDone;
+  critical_section_t _lock;
+  bool _reserved = false;
+
+  // a buffer waits for one latch alarm at a time, so the pool has an alarm
+  // for every buffer that reserved one
+  static alarm_pool_t* _latchPool;
+  static uint _reservedAlarms;
+  static bool reserveAlarm();
+
+  void startPendingFrame();
+  void transfer(const void* data);
+  bool claimDirect();
+  void transferDone();
+  static int64_t latchDone(alarm_id_t id, void* user_data);
+};
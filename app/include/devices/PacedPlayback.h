@@ -0,0 +1,60 @@
+#pragma once
+
+#include "devices/WS2812.h"
+
+#include "pico/time.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Pattern playback paced by a hardware alarm instead of a mainloop task. The
+// alarm fires at a fixed rate (microseconds, rescheduled from its target time,
+// so it does not drift) and starts the DMA of the frame straight from the
+// pattern data, e.g. the memory mapped file in flash. The CPU only picks the
+// next frame, so the frames start without the jitter of the mainloop at any
+// frame rate. The strip has to take the pattern as it is
+// (WS2812::canSendDirect()), the playback ends when it no longer does (e.g. a
+// LUT, dithering or a power budget was set). A frame the strip did not take in time is
+// skipped and counted as dropped by its FrameGovernor. Looped on a strip fed
+// by DMA, a frame that runs over the end of the pattern is sent in two
+// segments (WS2812::useSegments()), the end and the start of the pattern.
+class PacedPlayback {
+public:
+  // pattern holds pixels in the storage format of the strip, offsetJump
+  // pixels from one frame to the next
+  PacedPlayback(std::shared_ptr<WS2812> strip, const void* pattern, size_t pixels, bool packed, int offsetJump,
+                uint32_t periodUs, bool loop);
+  ~PacedPlayback();
+
+  // false if the alarm pool has no free alarm
+  bool start();
+  void stop();
+  bool isFinished() const { return !_playing; }
+
+  const std::string getDeviceName() const { return _strip->getName(); }
+  uint32_t getPeriodUs() const { return _periodUs; }
+
+private:
+  std::shared_ptr<WS2812> _strip;
+  const uint8_t* _pattern;
+  size_t _pixels;
+  bool _packed;
+  size_t _pixelBytes;
+  size_t _pixelTransfers; // DMA transfers per pixel
+  int _offsetJump;
+  uint32_t _periodUs;
+  bool _loop;
+
+  size_t _offset = 0;
+  bool _wrap = false; // frames over the end are sent in two segments (DMAChain)
+  alarm_id_t _alarm = -1;
+  volatile bool _playing = false;
+  volatile bool _inCallback = false;
+
+  // the first frame is sent from the alarm too
+  static constexpr uint32_t START_DELAY_US = 100;
+
+  bool nextFrame();
+  static int64_t alarmCallback(alarm_id_t id, void* user_data);
+};
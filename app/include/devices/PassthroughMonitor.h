@@ -6,6 +6,7 @@
 #include "Utils/Signal.h"
 
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <map>
 #include <memory>
@@ -32,6 +33,7 @@ public:
     }
 
     bool registerDataReceivedCallback(Mainloop::Function func, Signal signal = 0) override;
+    void unregisterDataReceivedCallback() override;
 
     int getBufferSize() const override {
         return _fifo.capacity();
@@ -44,6 +46,7 @@ public:
 
     IRQFifo _fifo;
     Signal _irq_signal = 0;
+    TaskPID _callbackTask = Mainloop::INVALID_PID;
 
     void receivedData(const uint8_t* data, size_t length);
   };
@@ -33,6 +33,7 @@ public:
     }
 
     bool registerDataReceivedCallback(Mainloop::Function func, Signal signal = 0) override;
+    void unregisterDataReceivedCallback() override;
 
     int getBufferSize() const override {
         return _rx_fifo.capacity();
@@ -47,6 +48,7 @@ private:
     IRQFifo _rx_fifo;
 
     Signal _irq_signal = 0;
+    TaskPID _callbackTask = Mainloop::INVALID_PID;
 
     static UARTDevice* _instances[2];
     static void on_uart0_rx();
@@ -25,6 +25,7 @@ public:
     int receive(uint8_t* buffer, size_t length) override;
 
     bool registerDataReceivedCallback(Mainloop::Function func, Signal signal = 0) override;
+    void unregisterDataReceivedCallback() override;
 
     int getBufferSize() const override {
         return 64;
@@ -33,6 +34,7 @@ public:
 private:
     int _interface_number;
     Signal _irq_signal = 0;
+    TaskPID _callbackTask = Mainloop::INVALID_PID;
 
     bool ExecuteTask();
 };
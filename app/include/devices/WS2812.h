@@ -1,33 +1,78 @@
 #pragma once
 
 #include "devices/IDevice.h"
+#include "devices/ILEDStrip.h"
 #include "devices/PIODevice.h"
+#include "devices/PIOFrameBuffer.h"
+#include "LED/LEDFrame.h"
+#include "LED/PowerLimiter.h"
+#include "LED/TemporalDither.h"
+#include "ITask.h"
 
 #include <cstdint>
 #include <vector>
 #include <memory>
 #include <string>
 
-class WS2812 : public ICreateSharedFromThis<WS2812>, public IDevice {
+class WS2812 : public ICreateSharedFromThis<WS2812>, public IDevice, public ILEDStrip {
 public:
   WS2812(std::shared_ptr<PIODevice> pio, uint pin, uint num_leds, uint bits_per_pixel = 24,
          float freq = 800000, const std::string& name = "WS2812");
+  ~WS2812();
 
   const std::string getName() const override { return _name; }
   const std::string getType() const override { return "WS2812"; }
   const std::string getDetails() const override;
 
+  // The strip is double buffered (PIOFrameBuffer): render all getLEDCount()
+  // pixels into the back buffer (it holds an older frame) and queue them with
+  // present(). With 24 bits per pixel the frames are packed (3 bytes per LED).
+  LEDFrame getBackBuffer();
+  bool present();
+  // Never with dithering, a new frame replaces the 16 bit frame
+  bool isFramePending() const override { return _frames && !_dither && _frames->isFramePending(); }
+  bool isPacked() const { return _bits_per_pixel == 24; }
+  // Frames in the storage format of the strip (packed or 0xRRGGBBWW words)
+  // can be sent without a copy, see PIOFrameBuffer::sendDirect(). Not with a
+  // color LUT (it is applied while copying), power limit, dithering or in a
+  // group.
+  bool canSendDirect(const void* data, bool packed) const;
+  bool sendDirect(const void* data);
+  // Frames put together from several pieces (DMAChain), e.g. a looped pattern
+  // that wraps around its end. Only for strips fed by DMA; their frames then
+  // start through the control channel, also in a group.
+  bool useSegments(size_t max_segments);
+  // count of each segment: bytes for packed frames, pixels otherwise
+  bool sendDirect(const DMAChain::Segment* segments, size_t count);
+  // nullptr if the strip failed to initialize, used by LEDGroup
+  PIOFrameBuffer* getFrameBuffer() { return _frames.get(); }
+
+  // Temporal dithering (TemporalDither): the frames are kept with 16 bits per
+  // channel, a low priority task sends dithered 8 bit frames as fast as the
+  // strip takes them. Call on LED_RENDER_CORE, the task runs there.
+  bool setDithering(bool enabled);
+  bool isDithering() const { return _dither != nullptr; }
+
   // Set the pattern for the LEDs
   // The pattern is a vector of uint32_t, where each uint32_t represents
+  /// The pattern is copied into the back buffer and presented, a queued frame
+  /// that was not sent yet is replaced (use isFramePending() to avoid that)
   /// returns true if the pattern was set successfully
   /// returns false if the pattern size was less than the number of LEDs
-  /// returns false if the DMA is already busy
   bool setPattern(const std::vector<uint32_t> &pattern){
     return setPattern(pattern.data(), pattern.size());
   }
-  bool setPattern(const uint32_t* data, size_t count);
+  bool setPattern(const uint32_t* data, size_t count) override;
+  bool setPackedPattern(const uint8_t* data, size_t count) override;
+
+  size_t getLEDCount() const override { return _num_leds; }
+  ColorLUT& getColorLUT() override { return _lut; }
+  FrameGovernor& getFrameGovernor() override { return _governor; }
+  // Applied to every frame as it is presented, also to the dithered frames
+  PowerLimiter& getPowerLimiter() { return _power; }
 
-  size_t getLEDCount() const { return _num_leds; }
+  // Minimum low time that latches the frame (WS2812B: 280 us)
+  static constexpr uint32_t RESET_US = 300;
 
 private:
   std::shared_ptr<PIODevice> _pio;
@@ -36,7 +81,31 @@ private:
   size_t _num_leds;
   std::string _name;
 
+  std::unique_ptr<PIOFrameBuffer> _frames;
+  ColorLUT _lut;
+  FrameGovernor _governor{0};
+  PowerLimiter _power;
+  std::unique_ptr<TemporalDither> _dither;
+  TaskPID _ditherTask = -1;
+  // Shared with the dither task: the kill is queued, so the task may run once
+  // more after it. It skips the strip when stopped, the strip waits while it
+  // runs on the other core.
+  struct DitherTaskState {
+    WS2812* strip;
+    volatile bool stopped = false;
+    volatile bool running = false;
+  };
+  std::shared_ptr<DitherTaskState> _ditherState;
+
+  bool refreshDither();
+  void stopDither();
+  // Channel bytes of a frame: packed or one word per LED
+  size_t getFrameBytes() const { return _num_leds * (isPacked() ? PackedPixel::BYTES : sizeof(uint32_t)); }
+
   static constexpr int DMA_THRESHOLD = 16;
+  // Entries (pixels or bytes of packed frames) still in the joined TX FIFO and
+  // the OSR when the DMA finished
+  static constexpr uint32_t FIFO_ENTRIES = 9;
 
   static int _program_offset_pio[2];
 };
\ No newline at end of file
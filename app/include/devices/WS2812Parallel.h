@@ -0,0 +1,58 @@
+#pragma once
+
+#include "devices/IDevice.h"
+#include "devices/ILEDStrip.h"
+#include "devices/PIODevice.h"
+#include "devices/PIOFrameBuffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Up to 16 WS2812 strips of the same length on consecutive pins, driven by one
+// PIO state machine and one DMA channel. The frames of the strips are
+// converted into bit planes (LED/BitPlane.h) when they are set, the planes are
+// double buffered like the frames of WS2812.
+class WS2812Parallel : public ICreateSharedFromThis<WS2812Parallel>, public IDevice, public ILEDStrip {
+public:
+  WS2812Parallel(std::shared_ptr<PIODevice> pio, uint first_pin, uint strips, uint num_leds, uint bits_per_pixel = 24,
+                 float freq = 800000, const std::string& name = "WS2812P");
+
+  const std::string getName() const override { return _name; }
+  const std::string getType() const override { return "WS2812P"; }
+  const std::string getDetails() const override;
+
+  /// One frame holds the strips one after the other: the pixels of strip s
+  /// start at data[s * getLEDsPerStrip()]
+  /// returns false if count is less than getLEDCount()
+  bool setPattern(const uint32_t* data, size_t count) override;
+  bool setPackedPattern(const uint8_t* data, size_t count) override;
+  /// strips[s] points to the getLEDsPerStrip() pixels of strip s
+  bool setStrips(const uint32_t* const* strips);
+
+  // Pixels of all strips
+  size_t getLEDCount() const override { return _strips * _num_leds; }
+  size_t getStripCount() const { return _strips; }
+  size_t getLEDsPerStrip() const { return _num_leds; }
+  bool isFramePending() const override { return _frames && _frames->isFramePending(); }
+  ColorLUT& getColorLUT() override { return _lut; }
+  FrameGovernor& getFrameGovernor() override { return _governor; }
+
+  static constexpr uint MAX_STRIPS = 16;
+
+private:
+  std::shared_ptr<PIODevice> _pio;
+  uint8_t _first_pin;
+  uint8_t _strips;
+  uint8_t _bits_per_pixel;
+  size_t _num_leds;
+  std::string _name;
+
+  std::unique_ptr<PIOFrameBuffer> _frames;
+  ColorLUT _lut;
+  FrameGovernor _governor{0};
+
+  // per PIO and plane width (8 or 16 strips)
+  static int _program_offset_pio[2][2];
+};
@@ -31,12 +31,12 @@ private:
   TaskPID _scrollingTask;
 
   std::vector<uint32_t> _ledData;
-  std::vector<uint32_t> _currentFrame;
   int _total_columns;
   int _current_offset;
   int _bit_vector_length;
   ScrollingDirection _scrollingDirection = ScrollingDirection::LEFT;
   bool _scrollingEnabled;
 
+  void updateValue(const std::string& value);
   bool scrollText();
 };
\ No newline at end of file
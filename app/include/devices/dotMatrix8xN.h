@@ -32,10 +32,11 @@ private:
   ScrollingDirection _scrollingDirection = ScrollingDirection::LEFT;
 
   std::vector<uint8_t> _ledData;
-  std::vector<uint32_t> _currentFrame;
+  size_t _frameSize; // LEDs of complete 8 LED columns
   
   int _current_offset;
 
+  void updateValue(const std::string& value);
   bool scrollText();
   bool staticText();
 };
\ No newline at end of file
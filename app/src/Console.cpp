@@ -1,5 +1,6 @@
 #include "Console.h"
 #include "Config.h"
+#include "Mainloop.h"
 #include "hardware/clocks.h"
 #include "pico/stdlib.h"
 #include "tusb.h"
@@ -119,15 +120,25 @@ bool Console::ExecuteLine(const std::string &line) {
 bool Console::ExecuteTask(TaskPID pid) {
   pidVariable->set(static_cast<int>(pid));
 
-  // Process commands from the queue first
-  if (!commandQueue.empty()) {
+  // Process commands from the queue first, as many as fit into the time
+  // budget of this iteration. Stop as well when a command put the console to
+  // sleep (e.g. sleep in a script).
+  auto &mainloop = Mainloop::getInstance();
+  while (!commandQueue.empty()) {
     std::string command = commandQueue.front();
     commandQueue.pop();
     ExecuteLine(command);
+    if (mainloop.shouldYield() || mainloop.isTaskSleeping(pid)) {
+      break;
+    }
   }
 
   // Then read from UART
-  return ReadUART();
+  bool result = ReadUART();
+  if (commandQueue.empty() && tud_cdc_n_available(INTERFACE_NUMBER) == 0) {
+    Mainloop::getInstance().reportIdle();
+  }
+  return result;
 }
 
 bool Console::ReadUART() {
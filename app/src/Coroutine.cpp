@@ -0,0 +1,19 @@
+#include "Coroutine.h"
+#include "devices/PIODevice.h"
+
+bool Coroutine::DmaAwaiter::await_ready() const {
+  return !device.isAsync() || !device.isBusy();
+}
+
+bool Coroutine::DmaAwaiter::await_suspend(Handle handle) const {
+  Signal signal = TRANSFER_DONE_SIGNAL | (device.getPIONumber() * 4 + device.getSM());
+  // PIODevice acknowledges the interrupt, the callback only raises the signal
+  device.setTransferDoneCallback([signal]() { Mainloop::getInstance().triggerSignal(signal); });
+  if (!device.isBusy()) {
+    return false; // finished before the callback was set
+  }
+  // The signal is matched in thread context, so a transfer that finishes
+  // before the waiter is registered still wakes it
+  Mainloop::getInstance().waitForSignal(handle.promise().pid, {signal, 0xFFFFFFFF});
+  return true;
+}
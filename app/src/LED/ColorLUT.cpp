@@ -0,0 +1,123 @@
+#include "LED/ColorLUT.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+#if PICO_ON_DEVICE
+#include "hardware/interp.h"
+#endif
+
+static const char CHANNELS[] = "RGBW";
+
+ColorLUT::ColorLUT() { rebuild(); }
+
+void ColorLUT::setBrightness(uint8_t brightness) {
+  _brightness = brightness;
+  rebuild();
+}
+
+bool ColorLUT::setGamma(float gamma) {
+  if (!(gamma >= 0.1f && gamma <= 5.0f)) {
+    return false;
+  }
+  _gamma = gamma;
+  rebuild();
+  return true;
+}
+
+void ColorLUT::setBalance(uint32_t balance) {
+  _balance = balance;
+  rebuild();
+}
+
+bool ColorLUT::setOrder(const std::string& order) {
+  std::string result;
+  for (char c : order) {
+    c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    if (strchr(CHANNELS, c) == nullptr || c == '\0' || result.find(c) != std::string::npos) {
+      return false;
+    }
+    result += c;
+  }
+  for (const char* c = CHANNELS; *c != '\0'; c++) {
+    if (result.find(*c) == std::string::npos) {
+      result += *c;
+    }
+  }
+  _order = result;
+  rebuild();
+  return true;
+}
+
+void ColorLUT::rebuild() {
+  _identity = _brightness == 255 && _gamma == 1.0f && _balance == 0xFFFFFFFF && _order == CHANNELS;
+  for (unsigned lane = 0; lane < 4; lane++) {
+    int channel = strchr(CHANNELS, _order[lane]) - CHANNELS; // 0 = R, bits 31..24
+    _shift[lane] = 24 - channel * 8;
+    for (int value = 0; value < 256; value++) {
+      _table[lane][value] = static_cast<uint8_t>(output(lane, value) + 0.5f);
+    }
+  }
+  _revision++;
+}
+
+float ColorLUT::output(unsigned lane, uint8_t value) const {
+  float scale = _brightness * static_cast<float>((_balance >> _shift[lane]) & 0xFF) / (255.0f * 255.0f);
+  float linear = _gamma == 1.0f ? value / 255.0f : powf(value / 255.0f, _gamma);
+  return linear * scale * 255.0f;
+}
+
+uint16_t ColorLUT::map16(unsigned lane, uint8_t value) const {
+  return static_cast<uint16_t>(output(lane, value) * 256.0f + 0.5f);
+}
+
+void ColorLUT::apply(const uint32_t* in, uint32_t* out, size_t count) const {
+  if (_identity) {
+    if (in != out) {
+      memcpy(out, in, count * sizeof(uint32_t));
+    }
+    return;
+  }
+#if PICO_ON_DEVICE
+  // The interpolators of this core compute the table entry of each lane,
+  // _table[lane] + ((pixel >> _shift[lane]) & 0xFF): interp0 for lanes 0 and
+  // 1, interp1 for lanes 2 and 3. The second lane of each reads the
+  // accumulator of the first, so a pixel is written once per interpolator.
+  interp_hw_save_t saved[2];
+  interp_hw_t* interps[2] = {interp0, interp1};
+  for (unsigned i = 0; i < 2; i++) {
+    interp_save(interps[i], &saved[i]);
+    for (unsigned lane = 0; lane < 2; lane++) {
+      interp_config config = interp_default_config();
+      interp_config_set_shift(&config, _shift[i * 2 + lane]);
+      interp_config_set_mask(&config, 0, 7);
+      interp_config_set_cross_input(&config, lane == 1);
+      interp_set_config(interps[i], lane, &config);
+      interps[i]->base[lane] = reinterpret_cast<uintptr_t>(_table[i * 2 + lane]);
+    }
+  }
+  for (size_t i = 0; i < count; i++) {
+    interp0->accum[0] = in[i];
+    interp1->accum[0] = in[i];
+    out[i] = static_cast<uint32_t>(*reinterpret_cast<const uint8_t*>(interp0->peek[0])) << 24 |
+             static_cast<uint32_t>(*reinterpret_cast<const uint8_t*>(interp0->peek[1])) << 16 |
+             static_cast<uint32_t>(*reinterpret_cast<const uint8_t*>(interp1->peek[0])) << 8 |
+             static_cast<uint32_t>(*reinterpret_cast<const uint8_t*>(interp1->peek[1]));
+  }
+  interp_restore(interp0, &saved[0]);
+  interp_restore(interp1, &saved[1]);
+#else
+  // two pixels per iteration, the loads of the second one overlap the lookups of the first
+  size_t i = 0;
+  for (; i + 1 < count; i += 2) {
+    uint32_t a = in[i];
+    uint32_t b = in[i + 1];
+    out[i] = map(a);
+    out[i + 1] = map(b);
+  }
+  if (i < count) {
+    out[i] = map(in[i]);
+  }
+#endif
+}
@@ -0,0 +1,56 @@
+#include "LED/PowerLimiter.h"
+
+bool PowerLimiter::limit(uint8_t* data, size_t bytes, size_t leds) {
+  // in mA * 255 to keep the channel sum as it is
+  const uint64_t dynamic = static_cast<uint64_t>(channelSum(data, bytes)) * _channelMa;
+  const uint64_t idle = static_cast<uint64_t>(leds) * _idleUa * 255 / 1000;
+  _currentMa = static_cast<uint32_t>((dynamic + idle) / 255);
+  if (!isEnabled()) {
+    return false;
+  }
+  const uint64_t budget = static_cast<uint64_t>(_budgetMa) * 255;
+  if (dynamic + idle <= budget) {
+    return false;
+  }
+  // the idle current stays, only the channels are scaled
+  const uint64_t available = budget > idle ? budget - idle : 0;
+  scale(data, bytes, static_cast<uint32_t>(available * 256 / dynamic));
+  _clipped++;
+  return true;
+}
+
+uint32_t PowerLimiter::channelSum(const uint8_t* data, size_t bytes) {
+  const uint32_t* words = reinterpret_cast<const uint32_t*>(data);
+  const size_t count = bytes / 4;
+  uint32_t sum = 0;
+  size_t i = 0;
+  while (i < count) {
+    // two 16 bit lanes, each adds up to 2 * 255 per word: flushed every 128 words
+    uint32_t lanes = 0;
+    const size_t end = count - i > 128 ? i + 128 : count;
+    for (; i < end; i++) {
+      const uint32_t word = words[i];
+      lanes += (word & 0x00FF00FF) + ((word >> 8) & 0x00FF00FF);
+    }
+    sum += (lanes & 0xFFFF) + (lanes >> 16);
+  }
+  for (size_t b = count * 4; b < bytes; b++) {
+    sum += data[b];
+  }
+  return sum;
+}
+
+void PowerLimiter::scale(uint8_t* data, size_t bytes, uint32_t scale) {
+  uint32_t* words = reinterpret_cast<uint32_t*>(data);
+  const size_t count = bytes / 4;
+  // per 16 bit lane 255 * 256 at most, the products do not carry into the next lane
+  for (size_t i = 0; i < count; i++) {
+    const uint32_t word = words[i];
+    const uint32_t even = (((word & 0x00FF00FF) * scale) >> 8) & 0x00FF00FF;
+    const uint32_t odd = (((word >> 8) & 0x00FF00FF) * scale) & 0xFF00FF00;
+    words[i] = even | odd;
+  }
+  for (size_t b = count * 4; b < bytes; b++) {
+    data[b] = static_cast<uint8_t>((data[b] * scale) >> 8);
+  }
+}
@@ -0,0 +1,49 @@
+#include "LED/TemporalDither.h"
+
+TemporalDither::TemporalDither(size_t ledCount, unsigned lanes, const ColorLUT& lut)
+    : _count(ledCount), _lanes(lanes), _lut(lut), _revision(lut.getRevision() - 1) {
+  _frame.assign(_count * _lanes, 0);
+  // spread start values, so LEDs of the same color do not step at the same frame
+  _error.resize(_count * _lanes);
+  for (size_t i = 0; i < _error.size(); i++) {
+    _error[i] = static_cast<uint8_t>(i * 151);
+  }
+  update();
+}
+
+void TemporalDither::update() {
+  if (_revision == _lut.getRevision()) {
+    return;
+  }
+  _revision = _lut.getRevision();
+  for (unsigned lane = 0; lane < _lanes; lane++) {
+    for (int value = 0; value < 256; value++) {
+      _table[lane][value] = _lut.map16(lane, value);
+    }
+  }
+}
+
+void TemporalDither::render(uint8_t* out, bool packed) {
+  const uint16_t* frame = _frame.data();
+  uint8_t* error = _error.data();
+  if (packed) {
+    // the packed layout is the layout of the 16 bit frame
+    const size_t n = _count * _lanes;
+    for (size_t i = 0; i < n; i++) {
+      uint32_t sum = frame[i] + error[i]; // at most 0xFF00 + 0xFF
+      out[i] = static_cast<uint8_t>(sum >> 8);
+      error[i] = static_cast<uint8_t>(sum);
+    }
+    return;
+  }
+  uint32_t* words = reinterpret_cast<uint32_t*>(out);
+  for (size_t led = 0; led < _count; led++) {
+    uint32_t word = 0;
+    for (unsigned lane = 0; lane < _lanes; lane++, frame++, error++) {
+      uint32_t sum = *frame + *error;
+      word |= (sum >> 8) << (24 - lane * 8);
+      *error = static_cast<uint8_t>(sum);
+    }
+    words[led] = word;
+  }
+}
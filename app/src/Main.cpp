@@ -36,6 +36,8 @@
 #include "Commands/DeviceCommand.h"
 
 #include "Commands/TaskCommand.h"
+#include "Commands/TraceCommand.h"
+#include "Commands/ProfileCommand.h"
 #include "Commands/KillCommand.h"
 #include "Commands/SignalCommand.h"
 #include "Commands/SleepCommand.h"
@@ -109,6 +111,8 @@ int main() {
   console.registerCommand(std::make_shared<DeviceCommand>(variableStore, deviceRepo));
 
   console.registerCommand(std::make_shared<TaskCommand>());
+  console.registerCommand(std::make_shared<TraceCommand>());
+  console.registerCommand(std::make_shared<ProfileCommand>());
   console.registerCommand(std::make_shared<KillCommand>(mainloop));
   console.registerCommand(std::make_shared<SignalCommand>(mainloop, console, variableStore));
   console.registerCommand(std::make_shared<SleepCommand>(mainloop, console));
@@ -123,8 +127,11 @@ int main() {
   console.EnqueueCommand("env load");
   console.EnqueueCommand("exec ${init-script}");
 
-  mainloop.registerRegularTask(&console);
+  // commands and scripts must not delay the LED output
+  TaskPID consolePID = mainloop.registerRegularTask(&console);
+  mainloop.setTaskPriority(consolePID, Mainloop::Priority::Low);
 
+  Mainloop::startCore1();
   mainloop.start();
 
   return 0;
@@ -1,110 +1,497 @@
 #include "Mainloop.h"
+#include "Coroutine.h"
 
 #include "hardware/clocks.h"
 #include "hardware/irq.h"
+#include "pico/flash.h"
+#include "pico/multicore.h"
 
 #include "Utils/ValueConverter.h"
 #include "Utils/Signal.h"
+#include "Utils/Trace.h"
 
 #include <time.h>
 #include <cstring>
+#include <algorithm>
 #include <iomanip>
 
 Mainloop& Mainloop::getInstance() {
-    static Mainloop instance;
-    return instance;
+  return getInstance(get_core_num());
 }
 
-Mainloop::Mainloop() : _running(false), _systickCounter(0), _loop_statistic_ptr(0), _max_loop_time(0) {
+Mainloop& Mainloop::getInstance(int core) {
+  static Mainloop core0(0);
+  static Mainloop core1(1);
+  return core == 1 ? core1 : core0;
+}
+
+Mainloop::Mainloop(int core) : _core(core), _running(false), _loop_statistic_ptr(0), _max_loop_time(0),
+                               _loadWindowStart(0), _idleTime(0), _cpuLoad(0), _taskIdle(false),
+                               _iterationStart(0), _lowPriorityBudgetUs(DEFAULT_LOW_PRIORITY_BUDGET_US), _nextLowPriorityTask(0), _coalescedPeriods(1) {
+  static_assert(REQUEST_QUEUE_SIZE <= 32, "_freeRequests is a 32 bit mask");
+  static_assert(MAX_TASKS < NO_SLOT && MAX_TASKS <= SLOT_MASK + 1u, "Too many tasks for the PID layout");
+
   memset(_loop_statistic, 0, sizeof(_loop_statistic));
+  for (uint32_t i = 0; i < MAX_TASKS; i++) {
+    _slots[i] = {1, TaskKind::Free, TaskKind::Free, false, 0, static_cast<uint16_t>(i + 1 < MAX_TASKS ? i + 1 : NO_SLOT)};
+  }
+  _freeSlot = 0;
+  memset(_reservedTasks, 0, sizeof(_reservedTasks));
+  _killPending = false;
+  _freeRequests = (REQUEST_QUEUE_SIZE == 32) ? 0xFFFFFFFF : ((1u << REQUEST_QUEUE_SIZE) - 1);
+  _timerQueue.reserve(TIMER_QUEUE_CAPACITY);
+  // core 0 runs from the start, core 1 only accepts requests once it is launched
+  _started = (core == 0);
+
+  queue_init(&_requestQueue, sizeof(uint8_t), REQUEST_QUEUE_SIZE);
+  queue_init(&_signalQueue, sizeof(Signal), SIGNAL_QUEUE_SIZE);
+  critical_section_init(&_lock);
 }
 
-// Static callback function for the alarm
-bool Mainloop::alarm_callback(repeating_timer *rt) {
-  Mainloop *instance = static_cast<Mainloop *>(rt->user_data);
-  instance->onMillisecond();
-  return true; // Return true to keep the timer running
+void Mainloop::startCore1() {
+  Mainloop &core1 = getInstance(1);
+  if (core1._started) {
+    return;
+  }
+  core1._started = true;
+  multicore_launch_core1([]() {
+    // core 1 runs from XIP too: flash_safe_execute() (FlashHAL) has to be able
+    // to park it while the flash is erased or programmed
+    flash_safe_execute_core_init();
+    getInstance(1).start();
+  });
 }
 
-// Start the mainloop
-void Mainloop::start() {
-  _running = true;
+TaskPID Mainloop::allocatePID(TaskKind kind) {
+  static const uint16_t capacity[] = {MAX_REGULAR_TASKS, MAX_TIMED_TASKS, MAX_SIGNAL_TASKS};
+  int pool = static_cast<int>(kind);
 
-  // Create a repeating timer
-  repeating_timer_t timer;
-  add_repeating_timer_ms(1, alarm_callback, this, &timer);
+  critical_section_enter_blocking(&_lock);
+  uint16_t slot = NO_SLOT;
+  if (_reservedTasks[pool] < capacity[pool]) {
+    slot = _freeSlot;
+    _freeSlot = _slots[slot].nextFree;
+    _slots[slot].kind = TaskKind::Reserved;
+    _slots[slot].reservedKind = kind;
+    _slots[slot].killRequested = false;
+    _reservedTasks[pool]++;
+  }
+  critical_section_exit(&_lock);
+  if (slot == NO_SLOT) {
+    return INVALID_PID;
+  }
+  TaskPID coreFlag = (_core == 1) ? CORE1_PID_FLAG : 0;
+  return (static_cast<TaskPID>(_slots[slot].generation) << GENERATION_SHIFT) | coreFlag | slot;
+}
 
-  while (_running) {
-    // Execute timed tasks
-    uint64_t loop_start = time_us_64();
-    for (auto &task : _timedTasks) {
-      if (task.execute) {
-        task.info.startTime = time_us_64();
-        if(!task.info.func(task.info.pid)){
-          task.intervalMs = -1; // mark the Task for removal
+void Mainloop::releaseSlot(uint16_t slot) {
+  critical_section_enter_blocking(&_lock);
+  TaskSlot &entry = _slots[slot];
+  _reservedTasks[static_cast<int>(entry.reservedKind)]--;
+  // a new generation invalidates all PIDs handed out for this slot
+  entry.generation = (entry.generation + 1) & GENERATION_MASK;
+  if (entry.generation == 0) {
+    entry.generation = 1;
+  }
+  entry.kind = TaskKind::Free;
+  entry.nextFree = _freeSlot;
+  _freeSlot = slot;
+  critical_section_exit(&_lock);
+}
+
+uint16_t Mainloop::findSlot(TaskPID handle) const {
+  if (handle < 0 || getTaskCore(handle) != _core) {
+    return NO_SLOT;
+  }
+  uint32_t slot = handle & SLOT_MASK;
+  if (slot >= MAX_TASKS) {
+    return NO_SLOT;
+  }
+  const TaskSlot &entry = _slots[slot];
+  if (entry.generation != ((handle >> GENERATION_SHIFT) & GENERATION_MASK) ||
+      entry.kind == TaskKind::Free || entry.kind == TaskKind::Reserved) {
+    return NO_SLOT;
+  }
+  return slot;
+}
+
+void Mainloop::insertTask(TaskPID handle, size_t index) {
+  TaskSlot &entry = _slots[handle & SLOT_MASK];
+  entry.kind = entry.reservedKind;
+  entry.index = index;
+}
+
+void Mainloop::requestKill(TaskPID handle) {
+  uint16_t slot = findSlot(handle);
+  if (slot != NO_SLOT) {
+    _slots[slot].killRequested = true;
+    _killPending = true;
+  }
+}
+
+// Moves the last task into the gap instead of shifting the pool
+template <typename T>
+void Mainloop::eraseTask(T &tasks, size_t index) {
+  if (index + 1 != tasks.size()) {
+    tasks[index] = std::move(tasks.back());
+    _slots[tasks[index].info.pid & SLOT_MASK].index = index;
+  }
+  tasks.pop_back();
+}
+
+void Mainloop::removeTask(uint16_t slot) {
+  TaskSlot &entry = _slots[slot];
+  switch (entry.kind) {
+    case TaskKind::Regular:
+      eraseTask(_regularTasks, entry.index);
+      break;
+    case TaskKind::Timed:
+      if (_timedTasks[entry.index].waitsForSignal) {
+        _signalWaiters.remove(slot);
+      }
+      // a pending timer queue entry of the slot is detected as stale
+      eraseTask(_timedTasks, entry.index);
+      break;
+    case TaskKind::Signal:
+      _signalIndex.remove(slot);
+      if (_signalTasks[entry.index].execute) {
+        for (size_t i = 0; i < _readySignalTasks.size(); i++) {
+          if (_readySignalTasks[i] == slot) {
+            _readySignalTasks[i] = _readySignalTasks.back();
+            _readySignalTasks.pop_back();
+            break;
+          }
         }
-        calculateStatistics(task.info);
-        task.execute = false;
       }
+      eraseTask(_signalTasks, entry.index);
+      break;
+    default:
+      return;
+  }
+  releaseSlot(slot);
+}
+
+int Mainloop::allocateRequest() {
+  critical_section_enter_blocking(&_lock);
+  int index = -1;
+  if (_freeRequests != 0) {
+    index = __builtin_ctz(_freeRequests);
+    _freeRequests &= ~(1u << index);
+  }
+  critical_section_exit(&_lock);
+  return index;
+}
+
+void Mainloop::invoke(Request func) {
+  if (isOwnCore() || !_started) {
+    func();
+    return;
+  }
+  int index;
+  while ((index = allocateRequest()) < 0) {
+    tight_loop_contents(); // the owning core frees the requests in its next iteration
+  }
+  _requests[index] = std::move(func);
+  uint8_t entry = static_cast<uint8_t>(index);
+  queue_add_blocking(&_requestQueue, &entry);
+}
+
+void Mainloop::processRequests() {
+  uint8_t index;
+  while (queue_try_remove(&_requestQueue, &index)) {
+    _requests[index]();
+    _requests[index].reset();
+    critical_section_enter_blocking(&_lock);
+    _freeRequests |= 1u << index;
+    critical_section_exit(&_lock);
+  }
+  Signal signal;
+  Mainloop &other = getInstance(1 - _core);
+  while (_pendingSignals.pop(signal)) {
+    matchSignal(signal);
+    if (other._started && !queue_try_add(&other._signalQueue, &signal)) {
+      _droppedForwards++;
     }
+  }
+  while (queue_try_remove(&_signalQueue, &signal)) {
+    matchSignal(signal);
+  }
+}
 
-    for (auto &task : _signalTasks) {
-      if (task.execute) {
-        task.info.startTime = time_us_64();
-        auto rerun = task.info.func(task.info.pid);
-        calculateStatistics(task.info);
-        task.execute = rerun;
-      }
+TaskPID Mainloop::registerRegularTask(const std::string &name, Function func, int core) {
+  Mainloop &target = getTarget(core);
+  TaskPID handle = target.allocatePID(TaskKind::Regular);
+  if (handle == INVALID_PID) {
+    return INVALID_PID;
+  }
+  TaskName taskName(name);
+  target.invoke([&target, handle, taskName, func]() {
+    target._regularTasks.push_back({{handle, taskName, func, 0, {}}, 0, Priority::Normal});
+    target.insertTask(handle, target._regularTasks.size() - 1);
+  });
+  return handle;
+}
+
+TaskPID Mainloop::registerTimedTask(const std::string &name, Function func, int32_t intervalMs, int32_t initialDelayMs, int core) {
+  Mainloop &target = getTarget(core);
+  TaskPID handle = target.allocatePID(TaskKind::Timed);
+  if (handle == INVALID_PID) {
+    return INVALID_PID;
+  }
+  TaskName taskName(name);
+  target.invoke([&target, handle, taskName, func, intervalMs, initialDelayMs]() {
+    target._timedTasks.push_back({{handle, taskName, func, 0, {}}, false, intervalMs, 0, false, OverrunPolicy::Skip, 0, {}, false});
+    target.insertTask(handle, target._timedTasks.size() - 1);
+    target.scheduleTimedTask(target._timedTasks.size() - 1, target.getSysTick() + initialDelayMs);
+  });
+  return handle;
+}
+
+TaskPID Mainloop::registerSignalTask(const std::string &name, Function func, SignalFilter filter, int core) {
+  Mainloop &target = getTarget(core);
+  TaskPID handle = target.allocatePID(TaskKind::Signal);
+  if (handle == INVALID_PID) {
+    return INVALID_PID;
+  }
+  TaskName taskName(name);
+  target.invoke([&target, handle, taskName, func, filter]() {
+    target._signalTasks.push_back({{handle, taskName, func, 0, {}}, filter, false});
+    target.insertTask(handle, target._signalTasks.size() - 1);
+    target._signalIndex.add(filter, handle & SLOT_MASK);
+  });
+  return handle;
+}
+
+bool Mainloop::sleepTask(TaskPID handle, uint32_t sleepTimeMs) {
+  Mainloop &owner = getInstance(getTaskCore(handle));
+  if (&owner != this) {
+    return owner.sleepTask(handle, sleepTimeMs);
+  }
+  if (!isOwnCore() && _started) {
+    invoke([this, handle, sleepTimeMs]() { sleepTask(handle, sleepTimeMs); });
+    return true;
+  }
+
+  uint16_t slot = findSlot(handle);
+  if (slot == NO_SLOT) {
+    return false;
+  }
+  const TaskSlot &entry = _slots[slot];
+  if (entry.kind == TaskKind::Regular) {
+    _regularTasks[entry.index].sleepUntil = getSysTick() + sleepTimeMs;
+    return true;
+  }
+  if (entry.kind == TaskKind::Timed) {
+    if (sleepTimeMs == 0 && _inTimedPass) {
+      return _nextIterationTasks.push_back(handle);
     }
+    scheduleTimedTask(entry.index, getSysTick() + sleepTimeMs);
+    return true;
+  }
+  return false;
+}
 
-    uint32_t currentTime = _systickCounter;
-    // Execute regular tasks
-    for (auto &task : _regularTasks) {
-      if(task.sleepUntil > currentTime){
-        continue;
-      }
-      task.info.startTime = time_us_64();
-      task.info.func(task.info.pid);
-      calculateStatistics(task.info);
+bool Mainloop::isTaskSleeping(TaskPID handle) const {
+  uint16_t slot = findSlot(handle);
+  if (slot == NO_SLOT || _slots[slot].kind != TaskKind::Regular) {
+    return false;
+  }
+  return _regularTasks[_slots[slot].index].sleepUntil > getSysTick();
+}
+
+bool Mainloop::setTaskPriority(TaskPID handle, Priority priority) {
+  Mainloop &owner = getInstance(getTaskCore(handle));
+  if (&owner != this) {
+    return owner.setTaskPriority(handle, priority);
+  }
+  if (!isOwnCore() && _started) {
+    invoke([this, handle, priority]() { setTaskPriority(handle, priority); });
+    return true;
+  }
+
+  uint16_t slot = findSlot(handle);
+  if (slot == NO_SLOT || _slots[slot].kind != TaskKind::Regular) {
+    return false;
+  }
+  _regularTasks[_slots[slot].index].priority = priority;
+  return true;
+}
+
+TaskPID Mainloop::registerCoroutine(const std::string &name, Coroutine &coroutine, int core) {
+  if (!coroutine) {
+    return INVALID_PID;
+  }
+  Coroutine::Handle handle = coroutine.handle();
+  // the first run starts the body, it suspends at its first co_await
+  return registerTimedTask(name, [handle](TaskPID pid) {
+    handle.promise().pid = pid;
+    handle.resume();
+    return !handle.done();
+  }, ON_DEMAND, 0, core);
+}
+
+bool Mainloop::waitForSignal(TaskPID handle, SignalFilter filter) {
+  uint16_t slot = findSlot(handle);
+  if (slot == NO_SLOT || _slots[slot].kind != TaskKind::Timed) {
+    return false;
+  }
+  TimedTaskInfo &task = _timedTasks[_slots[slot].index];
+  if (task.waitsForSignal) {
+    _signalWaiters.remove(slot);
+  }
+  _signalWaiters.add(filter, slot);
+  task.waitsForSignal = true;
+  return true;
+}
+
+bool Mainloop::modifyTimedTaskInterval(TaskPID handle, int32_t newIntervalMs) {
+  Mainloop &owner = getInstance(getTaskCore(handle));
+  if (&owner != this) {
+    return owner.modifyTimedTaskInterval(handle, newIntervalMs);
+  }
+  if (!isOwnCore() && _started) {
+    invoke([this, handle, newIntervalMs]() { modifyTimedTaskInterval(handle, newIntervalMs); });
+    return true;
+  }
+
+  uint16_t slot = findSlot(handle);
+  if (slot == NO_SLOT || _slots[slot].kind != TaskKind::Timed) {
+    return false;
+  }
+  size_t index = _slots[slot].index;
+  auto &task = _timedTasks[index];
+  int32_t difference = newIntervalMs - task.intervalMs;
+  uint32_t nextExecution = task.nextExecution + difference;
+  task.intervalMs = newIntervalMs;
+  uint32_t currentTime = getSysTick();
+  if (TimerQueue::isReached(nextExecution, currentTime)) {
+    nextExecution = currentTime; // execute in the next iteration
+  }
+  scheduleTimedTask(index, nextExecution);
+  return true;
+}
+
+bool Mainloop::setOverrunPolicy(TaskPID handle, OverrunPolicy policy) {
+  Mainloop &owner = getInstance(getTaskCore(handle));
+  if (&owner != this) {
+    return owner.setOverrunPolicy(handle, policy);
+  }
+  if (!isOwnCore() && _started) {
+    invoke([this, handle, policy]() { setOverrunPolicy(handle, policy); });
+    return true;
+  }
+
+  uint16_t slot = findSlot(handle);
+  if (slot == NO_SLOT || _slots[slot].kind != TaskKind::Timed) {
+    return false;
+  }
+  _timedTasks[_slots[slot].index].overrunPolicy = policy;
+  return true;
+}
+
+SignalFilter Mainloop::getSignalFilter(TaskPID handle) const {
+  uint16_t slot = findSlot(handle);
+  if (slot == NO_SLOT || _slots[slot].kind != TaskKind::Signal) {
+    return {0, 0};
+  }
+  return _signalTasks[_slots[slot].index].filter;
+}
+
+void Mainloop::killTask(TaskPID handle) {
+  Mainloop &owner = getInstance(getTaskCore(handle));
+  owner.invoke([&owner, handle]() { owner.requestKill(handle); });
+}
+
+void Mainloop::triggerSignal(Signal signal) {
+  // Constant time, no matter how many signal tasks exist. The interrupts are
+  // masked for the push only, so nested interrupts of the same core cannot
+  // interleave and the ring keeps a single producer.
+  Mainloop &local = getInstance();
+  Trace::record(Trace::Type::Signal, signal);
+  uint32_t status = save_and_disable_interrupts();
+  local._pendingSignals.push(signal);
+  restore_interrupts(status);
+}
+
+void Mainloop::matchSignal(Signal signal) {
+  _signalIndex.match(signal, [this](uint16_t slot) {
+    SignalTaskInfo &task = _signalTasks[_slots[slot].index];
+    if (!task.execute) {
+      task.execute = true;
+      _readySignalTasks.push_back(slot);
     }
+  });
+  wakeSignalWaiters(signal);
+}
 
-    // Remove completed timed tasks
-    for (int n = 0; n < _timedTasks.size(); n++) {
-      if (_timedTasks[n].intervalMs < 0) {
-        _timedTasks.erase(_timedTasks.begin() + n);
-        n--;
-      }
+void Mainloop::wakeSignalWaiters(Signal signal) {
+  // collected first, removing from the index while matching breaks the walk
+  FixedVector<uint16_t, MAX_TIMED_TASKS> woken;
+  _signalWaiters.match(signal, [&woken](uint16_t slot) { woken.push_back(slot); });
+  uint32_t currentTime = getSysTick();
+  for (uint16_t slot : woken) {
+    _signalWaiters.remove(slot);
+    size_t index = _slots[slot].index;
+    _timedTasks[index].waitsForSignal = false;
+    scheduleTimedTask(index, currentTime);
+  }
+}
+
+void Mainloop::executeSignalTasks(bool &idle) {
+  // Tasks that stay ready keep their place, finished ones are swapped out
+  size_t i = 0;
+  while (i < _readySignalTasks.size()) {
+    size_t index = _slots[_readySignalTasks[i]].index;
+    Trace::record(Trace::Type::TaskStart, _signalTasks[index].info.pid);
+    _signalTasks[index].info.startTime = time_us_64();
+    bool rerun = _signalTasks[index].info.func(_signalTasks[index].info.pid);
+    auto &task = _signalTasks[index];
+    calculateStatistics(task.info);
+    if (rerun) {
+      idle = false;
+      i++;
+    } else {
+      task.execute = false;
+      _readySignalTasks[i] = _readySignalTasks.back();
+      _readySignalTasks.pop_back();
     }
+  }
+}
 
-    for (int n = 0; n < _tasksToKill.size(); n++) {
-      TaskPID handle = _tasksToKill[n];
-      bool found = false;
-      for (int i = 0; i < _regularTasks.size(); i++) {
-        if (_regularTasks[i].info.pid == handle) {
-          _regularTasks.erase(_regularTasks.begin() + i);
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
-        for (int i = 0; i < _timedTasks.size(); i++) {
-          if (_timedTasks[i].info.pid == handle) {
-            _timedTasks.erase(_timedTasks.begin() + i);
-            found = true;
-            break;
-          }
-        }
-      }
-      if (!found) {
-        for (int i = 0; i < _signalTasks.size(); i++) {
-          if (_signalTasks[i].info.pid == handle) {
-            _signalTasks.erase(_signalTasks.begin() + i);
-            break;
-          }
+// Start the mainloop
+void Mainloop::start() {
+  _running = true;
+  _loadWindowStart = time_us_64();
+  _idleTime = 0;
+
+  while (_running) {
+    // Execute the requests of the other core
+    uint64_t loop_start = time_us_64();
+    _iterationStart = loop_start;
+    processRequests();
+
+    // Execute timed tasks
+    executeTimedTasks();
+
+    bool idle = true;
+    // Tasks may register new tasks while running, which appends to the pools,
+    // so the loops check the size again after every call
+    executeSignalTasks(idle);
+
+    // Execute regular tasks
+    if (!executeRegularTasks(getSysTick(), idle)) {
+      idle = false; // low priority tasks have been deferred
+    }
+
+    // Finished timed tasks are marked for removal as well
+    if (_killPending) {
+      _killPending = false;
+      for (uint16_t slot = 0; slot < MAX_TASKS; slot++) {
+        if (_slots[slot].killRequested && _slots[slot].kind != TaskKind::Free && _slots[slot].kind != TaskKind::Reserved) {
+          removeTask(slot);
         }
       }
     }
-    _tasksToKill.clear();
 
     uint64_t total_loop_time = time_us_64() - loop_start;
     if(total_loop_time <= static_cast<uint64_t>(static_cast<uint32_t>(-1))){
@@ -119,68 +506,300 @@ void Mainloop::start() {
     if(_loop_statistic_ptr >= 8){
       _loop_statistic_ptr = 0;
     }
+
+    if (idle) {
+      waitForEvent(getSysTick());
+    }
+    updateLoad(time_us_64());
+  }
+}
+
+// Returns true when something arrived during the iteration that has to be
+// handled before the core may sleep
+bool Mainloop::hasPendingWork() {
+  if (!_pendingSignals.empty() || !queue_is_empty(&_requestQueue) || !queue_is_empty(&_signalQueue)) {
+    return true;
+  }
+  return !_readySignalTasks.empty();
+}
+
+void Mainloop::waitForEvent(uint32_t currentTime) {
+  uint32_t sleepMs = MAX_IDLE_MS;
+  if (!_timerQueue.empty()) {
+    if (TimerQueue::isReached(_timerQueue.top().deadline, currentTime)) {
+      return;
+    }
+    sleepMs = std::min(sleepMs, _timerQueue.top().deadline - currentTime);
+  }
+  for (const auto &task : _regularTasks) {
+    if (task.sleepUntil > currentTime) {
+      sleepMs = std::min(sleepMs, task.sleepUntil - currentTime);
+    }
+  }
+  if (hasPendingWork()) {
+    return;
+  }
+
+  // An interrupt between the check above and the wait sets the event flag, so
+  // the wait returns immediately and no signal is lost. Queue adds of the other
+  // core send an event as well.
+  uint64_t idleStart = time_us_64();
+  uint64_t wakeup = (idleStart / 1000 + sleepMs) * 1000;
+  best_effort_wfe_or_timeout(from_us_since_boot(wakeup));
+  _idleTime += time_us_64() - idleStart;
+}
+
+// The load is the busy share of the last completed window
+void Mainloop::updateLoad(uint64_t now) {
+  uint64_t window = now - _loadWindowStart;
+  if (window < LOAD_WINDOW_US) {
+    return;
+  }
+  uint64_t idleTime = std::min(_idleTime, window);
+  _cpuLoad = 100.0f * static_cast<float>(window - idleTime) / static_cast<float>(window);
+  _loadWindowStart = now;
+  _idleTime = 0;
+}
+
+// Returns true when the task reported that it is idle
+bool Mainloop::executeRegularTask(size_t index) {
+  _taskIdle = false;
+  Trace::record(Trace::Type::TaskStart, _regularTasks[index].info.pid);
+  _regularTasks[index].info.startTime = time_us_64();
+  _regularTasks[index].info.func(_regularTasks[index].info.pid);
+  calculateStatistics(_regularTasks[index].info);
+  return _taskIdle;
+}
+
+// Returns false when low priority tasks had to be deferred to the next
+// iteration
+bool Mainloop::executeRegularTasks(uint32_t currentTime, bool &idle) {
+  for (Priority priority : {Priority::High, Priority::Normal}) {
+    for (size_t i = 0; i < _regularTasks.size(); i++) {
+      if (_regularTasks[i].priority != priority || _regularTasks[i].sleepUntil > currentTime) {
+        continue;
+      }
+      idle = executeRegularTask(i) && idle;
+    }
   }
 
-  // Cancel the timer when the loop stops
-  cancel_repeating_timer(&timer);
+  // At least one low priority task runs per iteration, so they cannot starve
+  size_t count = _regularTasks.size();
+  bool executed = false;
+  for (size_t n = 0; n < count; n++) {
+    size_t i = (_nextLowPriorityTask + n) % count;
+    if (_regularTasks[i].priority != Priority::Low || _regularTasks[i].sleepUntil > currentTime) {
+      continue;
+    }
+    if (executed && shouldYield()) {
+      _nextLowPriorityTask = i;
+      return false;
+    }
+    // serve timed tasks (e.g. LED frames) that became due in the meantime
+    executeTimedTasks();
+    idle = executeRegularTask(i) && idle;
+    executed = true;
+  }
+  _nextLowPriorityTask = 0;
+  return true;
 }
 
 void Mainloop::calculateStatistics(struct TaskInfo &task){
+  Trace::record(Trace::Type::TaskEnd, task.pid);
   uint64_t stopTime = time_us_64();
   if(task.startTime > stopTime){
     return;
   }
-  uint32_t executionTime = stopTime - task.startTime;
-  task.meanTime = (task.meanTime + executionTime) / 2;
-  if(executionTime > task.maxTime){
-    task.maxTime = executionTime;
+  uint64_t executionTime = stopTime - task.startTime;
+  task.executionTime.add(executionTime > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(executionTime));
+}
+
+void Mainloop::executeTimedTasks() {
+  uint32_t currentTime = getSysTick();
+  _inTimedPass = true;
+  while (_timerQueue.isDue(currentTime)) {
+    TimerQueue::Entry entry = _timerQueue.top();
+    const TaskSlot &slot = _slots[entry.id];
+    if (slot.kind != TaskKind::Timed || _timedTasks[slot.index].finished || !_timedTasks[slot.index].queued ||
+        _timedTasks[slot.index].nextExecution != entry.deadline) {
+      _timerQueue.pop(); // the task was removed or rescheduled, this entry is stale
+      continue;
+    }
+    size_t index = slot.index;
+    auto &task = _timedTasks[index];
+
+    // Schedule the next execution before running the task, so the task can
+    // still reschedule itself (e.g. with sleepTask)
+    uint32_t periods = 1;
+    if (task.intervalMs > 0) {
+      uint32_t interval = task.intervalMs;
+      uint32_t nextExecution = task.nextExecution + interval;
+      if (TimerQueue::isReached(nextExecution, currentTime)) {
+        // the next execution is due already, the task is at least one interval late
+        uint32_t missed = (currentTime - nextExecution) / interval + 1;
+        switch (task.overrunPolicy) {
+          case OverrunPolicy::CatchUp:
+            // a late catch up execution counts itself only, the next ones follow
+            task.overruns++;
+            if (missed > MAX_CATCH_UP) {
+              task.overruns += missed - MAX_CATCH_UP;
+              nextExecution += (missed - MAX_CATCH_UP) * interval;
+            }
+            break;
+          case OverrunPolicy::Coalesce:
+            periods += missed;
+            [[fallthrough]];
+          default:
+            task.overruns += missed;
+            nextExecution += missed * interval;
+            break;
+        }
+      }
+      task.nextExecution = nextExecution;
+      _timerQueue.replaceTop(nextExecution, entry.id);
+    } else {
+      task.queued = false;
+      _timerQueue.pop();
+    }
+
+    Trace::record(Trace::Type::TaskStart, task.info.pid);
+    task.info.startTime = time_us_64();
+    // the deadline is in ms, the start time in us
+    uint32_t startTick = static_cast<uint32_t>(task.info.startTime / 1000);
+    int32_t lateMs = static_cast<int32_t>(startTick - entry.deadline);
+    if (lateMs >= 0) {
+      task.lateness.add(static_cast<uint32_t>(lateMs) * 1000 + static_cast<uint32_t>(task.info.startTime % 1000));
+    }
+    _coalescedPeriods = periods;
+    bool keepRunning = task.info.func(task.info.pid);
+    _coalescedPeriods = 1;
+
+    // the task may have registered new tasks, so do not use the old reference
+    auto &executed = _timedTasks[index];
+    if (!keepRunning || (executed.intervalMs < 0 && executed.intervalMs != ON_DEMAND)) {
+      executed.finished = true; // mark the Task for removal
+      requestKill(executed.info.pid);
+    }
+    calculateStatistics(executed.info);
+  }
+  _inTimedPass = false;
+
+  for (TaskPID pid : _nextIterationTasks) {
+    uint16_t slot = findSlot(pid);
+    if (slot != NO_SLOT && _slots[slot].kind == TaskKind::Timed && !_timedTasks[_slots[slot].index].finished) {
+      scheduleTimedTask(_slots[slot].index, currentTime);
+    }
   }
+  _nextIterationTasks.clear();
 }
 
-// Function to be called every millisecond
-void Mainloop::onMillisecond() {
-  _systickCounter++;
-  for (auto &task : _timedTasks) {
-    if (_systickCounter == task.nextExecution) {
-      task.execute = true;
-      task.nextExecution += task.intervalMs;
+void Mainloop::scheduleTimedTask(size_t index, uint32_t nextExecution) {
+  _timedTasks[index].nextExecution = nextExecution;
+  _timedTasks[index].queued = true;
+  if (_timerQueue.size() >= TIMER_QUEUE_CAPACITY) {
+    // too many stale entries, rebuild the queue from the pool instead of growing it
+    _timerQueue.clear();
+    for (const TimedTaskInfo &task : _timedTasks) {
+      if (task.queued && !task.finished) {
+        _timerQueue.push(task.nextExecution, task.info.pid & SLOT_MASK);
+      }
     }
+    return;
   }
+  _timerQueue.push(nextExecution, _timedTasks[index].info.pid & SLOT_MASK);
+}
+
+void Mainloop::OutputTaskNames() const {
+  for (const auto &task : _regularTasks) {
+    std::cout << "task " << task.info.pid << " " << task.info.name.text << std::endl;
+  }
+  for (const auto &task : _timedTasks) {
+    std::cout << "task " << task.info.pid << " " << task.info.name.text << std::endl;
+  }
+  for (const auto &task : _signalTasks) {
+    std::cout << "task " << task.info.pid << " " << task.info.name.text << std::endl;
+  }
+}
+
+Mainloop::PoolUsage Mainloop::getPoolUsage() const {
+  return {static_cast<uint16_t>(_regularTasks.size()), static_cast<uint16_t>(_timedTasks.size()),
+          static_cast<uint16_t>(_signalTasks.size()),
+          static_cast<uint16_t>(REQUEST_QUEUE_SIZE - __builtin_popcount(_freeRequests))};
 }
 
-void Mainloop::OuptutTaskInformation() const {
-  float total_loop_time = 0;
+void Mainloop::resetStatistics() {
+  invoke([this]() {
+    for (auto &task : _regularTasks) {
+      task.info.executionTime.reset();
+    }
+    for (auto &task : _timedTasks) {
+      task.info.executionTime.reset();
+      task.lateness.reset();
+      task.overruns = 0;
+    }
+    for (auto &task : _signalTasks) {
+      task.info.executionTime.reset();
+    }
+    _max_loop_time = 0;
+  });
+}
+
+void Mainloop::OuptutTaskInformation(std::ostream &out) const {
+  uint32_t mean_loop_time = 0;
   for(int i = 0; i < 8; i++){
-    total_loop_time += _loop_statistic[i];
+    mean_loop_time += _loop_statistic[i] / 8;
+  }
+  uint32_t currentTime = getSysTick();
+  out << "Core " << _core << ":" << std::endl;
+  out << "CPU Load (last second): " << std::fixed << std::setprecision(2) << _cpuLoad << "% (mean loop time: " << mean_loop_time << "us, max loop time: " << _max_loop_time << "us)" << std::endl;
+  if (_pendingSignals.dropped() > 0 || _droppedForwards > 0) {
+    out << "Dropped signals: " << _pendingSignals.dropped() << " (not forwarded to core " << 1 - _core
+        << ": " << _droppedForwards << ")" << std::endl;
   }
-  total_loop_time /= 80;
-  std::cout << "Approximate CPU Load (per 1 ms): " << std::fixed << std::setprecision(2) << total_loop_time << "% (max time: " << _max_loop_time << "us)" << std::endl;
 
-  std::cout << "Regular Tasks:" << std::endl;
-  std::cout << " PID - Name (Mean Time / Max Time)" << std::endl;
+  out << "Regular Tasks:" << std::endl;
+  out << " PID - Name (Execution Time p50 / p90 / p99 / max)" << std::endl;
   for (const auto &task : _regularTasks) {
-    OuptutTaskInformation(task.info);
-    if (task.sleepUntil > _systickCounter){
-      std::cout << " [Sleeping for " << (task.sleepUntil - _systickCounter) << " ms]";
+    OuptutTaskInformation(out, task.info);
+    if (task.priority != Priority::Normal) {
+      out << (task.priority == Priority::High ? " [High priority]" : " [Low priority]");
+    }
+    if (task.sleepUntil > currentTime){
+      out << " [Sleeping for " << (task.sleepUntil - currentTime) << " ms]";
     } 
-    std::cout << std::endl;
+    out << std::endl;
   }
 
-  std::cout << std::endl << "Timed Tasks:" << std::endl;
-  std::cout << " PID - Name (Mean Time / Max Time)" << std::endl;
+  out << std::endl << "Timed Tasks:" << std::endl;
+  out << " PID - Name (Execution Time p50 / p90 / p99 / max)" << std::endl;
   for (const auto &task : _timedTasks) {
-    OuptutTaskInformation(task.info);
-    std::cout << " [Interval: " << task.intervalMs << " ms, next execution in " << (task.nextExecution - _systickCounter) << " ms]" << std::endl;
+    OuptutTaskInformation(out, task.info);
+    if (task.intervalMs == ON_DEMAND) {
+      out << " [On demand, " << (task.waitsForSignal ? "waiting for a signal" : "sleeping") << "]" << std::endl;
+      continue;
+    }
+    out << " [Interval: " << task.intervalMs << " ms, next execution in " << static_cast<int32_t>(task.nextExecution - currentTime)
+        << " ms, overruns: " << task.overruns;
+    if (task.overrunPolicy == OverrunPolicy::CatchUp) {
+      out << " (catch up)";
+    } else if (task.overrunPolicy == OverrunPolicy::Coalesce) {
+      out << " (coalesce)";
+    }
+    out << "]" << std::endl;
+    out << "     Start lateness: " << task.lateness.percentile(50) << " / " << task.lateness.percentile(90) << " / "
+        << task.lateness.percentile(99) << " / " << task.lateness.max() << " us" << std::endl;
   }
 
-  std::cout << std::endl << "Signal waiting Tasks:" << std::endl;
-  std::cout << " PID - Name (Mean Time / Max Time)" << std::endl;
+  out << std::endl << "Signal waiting Tasks:" << std::endl;
+  out << " PID - Name (Execution Time p50 / p90 / p99 / max)" << std::endl;
   for (const auto &task : _signalTasks) {
-    OuptutTaskInformation(task.info);
-    std::cout << " [on Signal: " << SignalConverter::toString(task.filter) << "]" << std::endl;
+    OuptutTaskInformation(out, task.info);
+    out << " [on Signal: " << SignalConverter::toString(task.filter) << "]" << std::endl;
   }
 }
 
-void Mainloop::OuptutTaskInformation(const struct TaskInfo &task) const {
-  std::cout << " " << task.pid <<" - " << task.name << " (" << task.meanTime << " us / " << task.maxTime << " us)";
+void Mainloop::OuptutTaskInformation(std::ostream &out, const struct TaskInfo &task) const {
+  const LatencyHistogram &time = task.executionTime;
+  out << " " << task.pid <<" - " << task.name.text << " (" << time.percentile(50) << " / " << time.percentile(90) << " / "
+      << time.percentile(99) << " / " << time.max() << " us)";
 }
@@ -0,0 +1,131 @@
+#include "Utils/Profiler.h"
+
+#include <iostream>
+
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+Profiler::Entry Profiler::_entries[PC_COUNT];
+volatile int Profiler::_alarm = -1;
+volatile bool Profiler::_paused = false;
+uint32_t Profiler::_periodUs = 0;
+uint32_t Profiler::_rateHz = 0;
+int Profiler::_core = 0;
+volatile uint32_t Profiler::_samples = 0;
+volatile uint32_t Profiler::_dropped = 0;
+
+// Probes before a sample is dropped, keeps the interrupt short when the table fills up
+static constexpr uint32_t MAX_PROBES = 8;
+
+extern "C" void __not_in_flash_func(profilerAlarmSample)(const uint32_t *frame) { Profiler::sample(frame); }
+
+// Entered directly from the vector table: passes the stack the exception frame
+// was pushed to (bit 2 of EXC_RETURN) and tail calls profilerAlarmSample, which
+// returns from the exception with the EXC_RETURN still in lr
+extern "C" __attribute__((naked)) void profilerAlarmIRQ() {
+  asm volatile("movs r0, #4\n"
+               "mov r1, lr\n"
+               "tst r0, r1\n"
+               "beq 1f\n"
+               "mrs r0, psp\n"
+               "b 2f\n"
+               "1:\n"
+               "mrs r0, msp\n"
+               "2:\n"
+               "ldr r1, 3f\n"
+               "bx r1\n"
+               ".align 2\n"
+               "3: .word profilerAlarmSample\n");
+}
+
+bool Profiler::start(uint32_t rateHz) {
+  if (isRunning() || rateHz == 0 || rateHz > 100000) {
+    return false;
+  }
+  int alarm = hardware_alarm_claim_unused(false);
+  if (alarm < 0) {
+    return false;
+  }
+  clear();
+  _rateHz = rateHz;
+  _periodUs = 1000000 / rateHz;
+  _core = get_core_num();
+  _paused = false;
+  _alarm = alarm;
+
+  // highest priority, so interrupt handlers are sampled as well
+  uint irq = hardware_alarm_get_irq_num(alarm);
+  irq_set_exclusive_handler(irq, profilerAlarmIRQ);
+  irq_set_priority(irq, PICO_HIGHEST_IRQ_PRIORITY);
+  hw_set_bits(&timer_hw->inte, 1u << alarm);
+  irq_set_enabled(irq, true);
+  timer_hw->alarm[alarm] = timer_hw->timerawl + _periodUs;
+  return true;
+}
+
+void Profiler::stop() {
+  int alarm = _alarm;
+  if (alarm < 0) {
+    return;
+  }
+  uint irq = hardware_alarm_get_irq_num(alarm);
+  irq_set_enabled(irq, false);
+  hw_clear_bits(&timer_hw->inte, 1u << alarm);
+  timer_hw->armed = 1u << alarm;
+  timer_hw->intr = 1u << alarm;
+  irq_remove_handler(irq, profilerAlarmIRQ);
+  hardware_alarm_unclaim(alarm);
+  _alarm = -1;
+}
+
+void Profiler::clear() {
+  for (Entry &entry : _entries) {
+    entry.pc = 0;
+    entry.count = 0;
+  }
+  _samples = 0;
+  _dropped = 0;
+}
+
+void Profiler::sample(const uint32_t *frame) {
+  int alarm = _alarm;
+  timer_hw->intr = 1u << alarm;
+  timer_hw->alarm[alarm] = timer_hw->timerawl + _periodUs;
+  if (_paused) {
+    return;
+  }
+
+  // r0 r1 r2 r3 r12 lr pc xpsr
+  uint32_t pc = frame[6];
+  uint32_t index = ((pc >> 1) * 0x9E3779B1u) >> 16;
+  for (uint32_t probe = 0; probe < MAX_PROBES; probe++) {
+    Entry &entry = _entries[(index + probe) & (PC_COUNT - 1)];
+    if (entry.pc == pc || entry.count == 0) {
+      entry.pc = pc;
+      entry.count++;
+      _samples = _samples + 1;
+      return;
+    }
+  }
+  _dropped = _dropped + 1;
+}
+
+// Format: "profile 1", "rate <hz> core <core> samples <n> dropped <n>",
+// one "pc <hex address> <count>" line per sampled address (unsorted), "end"
+void Profiler::dump() {
+  _paused = true;
+  // a sample of the other core may still be in progress
+  busy_wait_us(10);
+
+  std::cout << "profile 1" << std::endl;
+  std::cout << "rate " << _rateHz << " core " << _core << " samples " << _samples << " dropped " << _dropped
+            << std::endl;
+  for (const Entry &entry : _entries) {
+    if (entry.count != 0) {
+      std::cout << "pc " << std::hex << entry.pc << std::dec << " " << entry.count << std::endl;
+    }
+  }
+  std::cout << "end" << std::endl;
+  _paused = false;
+}
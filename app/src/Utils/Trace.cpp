@@ -0,0 +1,46 @@
+#include "Utils/Trace.h"
+
+#include <iostream>
+
+Trace::Ring Trace::_rings[2];
+volatile bool Trace::_enabled = true;
+
+void Trace::clear() {
+  bool enabled = _enabled;
+  _enabled = false;
+  for (Ring &ring : _rings) {
+    ring.head = 0;
+  }
+  _enabled = enabled;
+}
+
+// Format: "core <core> <events> <overwritten>", followed by lines of up to 8
+// events as hex bytes in memory order (little endian), oldest first
+void Trace::dump(int core) {
+  bool enabled = _enabled;
+  _enabled = false;
+  // an event of the other core or an interrupt may still be in progress
+  busy_wait_us(10);
+
+  const Ring &ring = _rings[core];
+  uint32_t head = ring.head;
+  uint32_t count = head < EVENT_COUNT ? head : EVENT_COUNT;
+  std::cout << "core " << core << " " << count << " " << (head - count) << std::endl;
+
+  static const char digits[] = "0123456789abcdef";
+  const uint32_t eventsPerLine = 8;
+  char line[3 + eventsPerLine * sizeof(Event) * 2 + 1] = "ev ";
+  for (uint32_t i = 0; i < count; i += eventsPerLine) {
+    char *out = line + 3;
+    for (uint32_t n = i; n < count && n < i + eventsPerLine; n++) {
+      const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&ring.events[(head - count + n) & (EVENT_COUNT - 1)]);
+      for (size_t b = 0; b < sizeof(Event); b++) {
+        *out++ = digits[bytes[b] >> 4];
+        *out++ = digits[bytes[b] & 0x0F];
+      }
+    }
+    *out = '\0';
+    std::cout << line << std::endl;
+  }
+  _enabled = enabled;
+}
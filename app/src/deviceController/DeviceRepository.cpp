@@ -3,6 +3,8 @@
 #include "deviceController/UARTFactory.h"
 #include "deviceController/PIOFactory.h"
 #include "deviceController/LEDFactory.h"
+#include "deviceController/LEDParallelFactory.h"
+#include "deviceController/LEDGroupFactory.h"
 #include "deviceController/LEDDisplayFactory.h"
 #include "deviceController/LEDStatusFactory.h"
 #include "deviceController/CommRouterFactory.h"
@@ -18,6 +20,8 @@ DeviceRepository::DeviceRepository(const Console& console) {
     _factories.push_back(std::make_shared<UARTFactory>());
     _factories.push_back(std::make_shared<ADCFactory>());
     _factories.push_back(std::make_shared<LEDFactory>(*this));
+    _factories.push_back(std::make_shared<LEDParallelFactory>(*this));
+    _factories.push_back(std::make_shared<LEDGroupFactory>(*this));
     _factories.push_back(std::make_shared<LEDDisplayFactory>(*this));
     _factories.push_back(std::make_shared<LEDStatusFactory>(*this, console));
     _factories.push_back(std::make_shared<CommRouterFactory>(*this));
@@ -0,0 +1,88 @@
+#include "devices/DMAChain.h"
+#include "Utils/Trace.h"
+
+DMAChain::DMAChain(uint data_channel, size_t max_segments) : _data(data_channel) {
+  _segments.assign(max_segments + 1, Segment{0, nullptr});
+  _control = dma_claim_unused_channel(false);
+  if (_control < 0) {
+    return;
+  }
+  // writes one segment (2 words) into the alias 3 registers per trigger, the
+  // write address wraps after 8 bytes
+  dma_channel_config cc = dma_channel_get_default_config(_control);
+  channel_config_set_transfer_data_size(&cc, DMA_SIZE_32);
+  channel_config_set_read_increment(&cc, true);
+  channel_config_set_write_increment(&cc, true);
+  channel_config_set_ring(&cc, true, 3);
+  dma_channel_configure(_control, &cc, &dma_hw->ch[_data].al3_transfer_count, _segments.data(), 2, false);
+
+  dma_channel_config dc = dma_get_channel_config(_data);
+  channel_config_set_chain_to(&dc, _control);
+  channel_config_set_irq_quiet(&dc, true);
+  dma_channel_set_config(_data, &dc, false);
+}
+
+DMAChain::~DMAChain() {
+  if (_control < 0) {
+    return;
+  }
+  dma_channel_abort(_control);
+  dma_channel_abort(_data);
+  dma_channel_unclaim(_control);
+  // chaining to itself disables the chain
+  dma_channel_config dc = dma_get_channel_config(_data);
+  channel_config_set_chain_to(&dc, _data);
+  channel_config_set_irq_quiet(&dc, false);
+  dma_channel_set_config(_data, &dc, false);
+}
+
+void DMAChain::clear() {
+  _used = 0;
+  _segments[0] = Segment{0, nullptr};
+}
+
+bool DMAChain::add(const void* data, uint32_t count) {
+  if (count == 0) {
+    return true;
+  }
+  if (_used >= getMaxSegments()) {
+    return false;
+  }
+  _segments[_used++] = Segment{count, data};
+  _segments[_used] = Segment{0, nullptr};
+  return true;
+}
+
+bool DMAChain::set(const Segment* segments, size_t count) {
+  clear();
+  for (size_t i = 0; i < count; i++) {
+    if (!add(segments[i].data, segments[i].count)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DMAChain::start() {
+  uint32_t mask = prepare();
+  if (mask == 0) {
+    return false;
+  }
+  dma_start_channel_mask(mask);
+  return true;
+}
+
+uint32_t DMAChain::prepare() {
+  if (_control < 0 || isBusy()) {
+    return 0;
+  }
+  Trace::record(Trace::Type::DmaStart, _data);
+  // the transfer count of 2 is reloaded with every start
+  dma_channel_set_read_addr(_control, _segments.data(), false);
+  return 1u << _control;
+}
+
+bool DMAChain::isBusy() const {
+  // the data channel triggers the control channel in the cycle it finishes
+  return _control >= 0 && (dma_channel_is_busy(_data) || dma_channel_is_busy(_control));
+}
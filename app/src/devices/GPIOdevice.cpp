@@ -1,6 +1,7 @@
 #include "devices/GPIODevice.h"
 #include "Utils/Signal.h"
 #include "Mainloop.h"
+#include "Utils/Trace.h"
 
 bool GPIODevice::_irq_initialized = false;
 
@@ -11,6 +12,7 @@ GPIODevice::GPIODevice(int gpio_number, GPIODevice::GPIOConfiguration config)
 
     if(!_irq_initialized) {
         gpio_set_irq_callback([](uint gpio, uint32_t events) {
+            Trace::recordIrq();
             Signal sig = 0x67703030;
 
             uint tens = (gpio * 0x19999A) >> 24; // Approximate division by 10
@@ -17,7 +17,11 @@ HLKDevice::HLKDevice(std::shared_ptr<ICommDevice> commDevice,
     return;
   }
 
-  _commDevice->registerDataReceivedCallback([this](TaskPID) { return ExecuteTask(); });
+  if(!_commDevice->registerDataReceivedCallback([this](TaskPID) { return ExecuteTask(); })) {
+    std::cerr << "Could not register the data callback of " << _commDevice->getName() << " for HLKDevice: " << name << std::endl;
+    _status = DeviceStatus::Error;
+    return;
+  }
 
   _status = DeviceStatus::Initialized;
 }
@@ -0,0 +1,139 @@
+#include "devices/LEDGroup.h"
+#include "hardware/dma.h"
+
+#include "Mainloop.h"
+
+#include <algorithm>
+
+LEDGroup::LEDGroup(std::vector<std::shared_ptr<WS2812>> strips, Signal signal, const std::string& name)
+    : _strips(std::move(strips)), _signal(signal), _name(name) {
+  critical_section_init(&_lock);
+  if (_strips.empty()) {
+    _status = DeviceStatus::Error;
+    return;
+  }
+  uint32_t frame_time = 0;
+  for (auto& strip : _strips) {
+    if (!strip->getFrameBuffer() || strip->getFrameBuffer()->isGrouped()) {
+      _status = DeviceStatus::Error;
+      return;
+    }
+    _num_leds += strip->getLEDCount();
+    frame_time = std::max(frame_time, strip->getFrameGovernor().getFrameTimeUs());
+  }
+  _governor = FrameGovernor(frame_time);
+
+  for (auto& strip : _strips) {
+    strip->getFrameBuffer()->setGroup([this]() { memberReady(); }, [this]() { memberDone(); });
+  }
+  _status = DeviceStatus::Initialized;
+}
+
+LEDGroup::~LEDGroup() {
+  if (_status != DeviceStatus::Error) {
+    // the members start their frames on their own again
+    for (auto& strip : _strips) {
+      strip->getFrameBuffer()->setGroup(nullptr, nullptr);
+    }
+  }
+  critical_section_deinit(&_lock);
+}
+
+const std::string LEDGroup::getDetails() const {
+  std::string details = "Group of " + std::to_string(_strips.size()) + " WS2812 strips:";
+  for (auto& strip : _strips) {
+    details += " " + strip->getName();
+  }
+  details += "\n" + std::to_string(_num_leds) + " LEDs, max " + std::to_string(_governor.getMaxFrameRate()) +
+             " frames/s, " + std::to_string(_framesSent) + " frames sent\nSignal: " + SignalConverter::toString(_signal);
+  return details;
+}
+
+bool LEDGroup::setPattern(const uint32_t* data, size_t count) {
+  if (count < _num_leds || _status == DeviceStatus::Error) {
+    return false;
+  }
+  bool replaced = isFramePending();
+  bool set = true;
+  for (auto& strip : _strips) {
+    set = strip->setPattern(data, strip->getLEDCount()) && set;
+    data += strip->getLEDCount();
+  }
+  _governor.presented(replaced);
+  return set;
+}
+
+bool LEDGroup::setPackedPattern(const uint8_t* data, size_t count) {
+  if (count < _num_leds || _status == DeviceStatus::Error) {
+    return false;
+  }
+  bool replaced = isFramePending();
+  bool set = true;
+  for (auto& strip : _strips) {
+    set = strip->setPackedPattern(data, strip->getLEDCount()) && set;
+    data += strip->getLEDCount() * PackedPixel::BYTES;
+  }
+  _governor.presented(replaced);
+  return set;
+}
+
+bool LEDGroup::isFramePending() const {
+  for (auto& strip : _strips) {
+    if (strip->isFramePending()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Called by every member that has a frame ready to start (thread context, DMA
+// or alarm interrupt), the last one starts the frame of the group. The
+// members are armed outside of the group lock: their locks may share its
+// hardware spin lock.
+void LEDGroup::memberReady() {
+  bool start = false;
+  critical_section_enter_blocking(&_lock);
+  if (_sending == 0) {
+    start = true;
+    for (auto& strip : _strips) {
+      start = start && strip->getFrameBuffer()->isReady();
+    }
+  }
+  if (start) {
+    _sending = _strips.size(); // claims the frame, later calls do not start it again
+  }
+  critical_section_exit(&_lock);
+  if (!start) {
+    return;
+  }
+  uint32_t mask = 0;
+  uint32_t unarmed = 0; // members started with send()
+  for (size_t i = 0; i < _strips.size(); i++) {
+    uint32_t channel = _strips[i]->getFrameBuffer()->arm();
+    if (channel == 0) {
+      unarmed |= 1u << i;
+    }
+    mask |= channel;
+  }
+  // one write starts all DMA channels
+  if (mask != 0) {
+    dma_start_channel_mask(mask);
+  }
+  for (size_t i = 0; unarmed != 0; i++, unarmed >>= 1) {
+    if (unarmed & 1) {
+      _strips[i]->getFrameBuffer()->send();
+    }
+  }
+}
+
+void LEDGroup::memberDone() {
+  critical_section_enter_blocking(&_lock);
+  bool last = _sending > 0 && --_sending == 0;
+  if (last) {
+    _framesSent++;
+  }
+  critical_section_exit(&_lock);
+  if (last) {
+    Mainloop::getInstance().triggerSignal(_signal);
+  }
+}
@@ -3,7 +3,6 @@
 
 LEDStatus::LEDStatus(std::shared_ptr<WS2812> led, const std::string& name, const std::string& initial_status)
     : _led(led), _name(name) {
-  _led_colors.resize(_led->getLEDCount(), 0);
   setStatus(initial_status);
     
   _status = DeviceStatus::Initialized;
@@ -21,8 +20,9 @@ const std::string LEDStatus::getDetails() const{
 bool LEDStatus::setStatus(const std::string& value){
   auto it = _status_colors.find(value);
   if (it != _status_colors.end()) {
-    _led_colors.assign(_led_colors.size(), it->second);
-    _led->setPattern(_led_colors);
+    // rendered directly into the back buffer, no copy of the frame is kept
+    _led->getBackBuffer().fill(0, _led->getLEDCount(), it->second);
+    _led->present();
     return true;
   }
 
@@ -6,7 +6,11 @@ Loopback::Loopback(std::shared_ptr<ICommDevice> commDevice, const std::string& n
 
 Loopback::Loopback(std::shared_ptr<ICommDevice> commDevice, const std::string& name, int buffersize)
     : _commDevice(commDevice), _name(name), _fifo(buffersize) {
-  _commDevice->registerDataReceivedCallback([this](TaskPID) { return ExecuteTask(); });
+  if(!_commDevice->registerDataReceivedCallback([this](TaskPID) { return ExecuteTask(); })) {
+    std::cerr << "Could not register the data callback of " << _commDevice->getName() << " for Loopback device: " << name << std::endl;
+    _status = DeviceStatus::Error;
+    return;
+  }
     
   _status = DeviceStatus::Initialized;
 }
@@ -17,11 +17,28 @@ MultiPassthrough::MultiPassthrough(std::shared_ptr<ICommDevice> commDeviceMain,
     return;
   }
 
-  _commDeviceMain->registerDataReceivedCallback([this](TaskPID) { return SignalTask(); });
-  _commDeviceA->registerDataReceivedCallback([this](TaskPID) { return SignalTask(); });
-  _commDeviceB->registerDataReceivedCallback([this](TaskPID) { return SignalTask(); });
+  std::shared_ptr<ICommDevice> devices[] = {_commDeviceMain, _commDeviceA, _commDeviceB};
+  for(size_t i = 0; i < 3; i++) {
+    if(!devices[i]->registerDataReceivedCallback([this](TaskPID) { return SignalTask(); })) {
+      std::cerr << "Could not register the data callback of " << devices[i]->getName() << " for MultiPassthrough device: " << name << std::endl;
+      for(size_t j = 0; j < i; j++) {
+        devices[j]->unregisterDataReceivedCallback();
+      }
+      _status = DeviceStatus::Error;
+      return;
+    }
+  }
 
-  Mainloop::getInstance().registerRegularTask(getName() + ".Worker", [this](TaskPID) { return ExecuteTask(); });
+  TaskPID worker = Mainloop::getInstance().registerRegularTask(getName() + ".Worker", [this](TaskPID) { return ExecuteTask(); });
+  if(worker == Mainloop::INVALID_PID) {
+    std::cerr << "No free task for the worker of MultiPassthrough device: " << name << std::endl;
+    for(auto& device : devices) {
+      device->unregisterDataReceivedCallback();
+    }
+    _status = DeviceStatus::Error;
+    return;
+  }
+  Mainloop::getInstance().setTaskPriority(worker, Mainloop::Priority::High);
     
   _status = DeviceStatus::Initialized;
 }
@@ -93,6 +110,9 @@ bool MultiPassthrough::ExecuteTask() {
       _fifoMainToBoth.remove(n);
     }
   }
+  if(_fifoAtoMain.count() == 0 && _fifoBtoMain.count() == 0 && _fifoMainToBoth.count() == 0) {
+    Mainloop::getInstance().reportIdle();
+  }
   return true;
 }
 
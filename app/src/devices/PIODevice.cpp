@@ -1,5 +1,13 @@
 #include "devices/PIODevice.h"
 #include "hardware/irq.h"
+#include "Utils/Trace.h"
+
+PIODevice *PIODevice::_dmaDevices[NUM_DMA_CHANNELS] = {};
+PIODevice *PIODevice::_fifoDevices[2][4] = {};
+
+static pio_interrupt_source_t txNotFullSource(uint sm) {
+    return static_cast<pio_interrupt_source_t>(pis_sm0_tx_fifo_not_full + sm);
+}
 
 PIODevice::PIODevice(int number) : _number(number) {
     _program_offset = -1;
@@ -59,9 +67,29 @@ bool PIODevice::useDMA(uint transfer_count, dma_channel_transfer_size_t size) {
     dma_channel_configure(_dma_channel, &dc, &_pio->txf[_sm], nullptr, transfer_count, false);
 
     _transfer_count = transfer_count;
+    _transfer_size = size;
     return true;
 }
 
+bool PIODevice::useDMAChain(size_t max_segments) {
+    if(_dma_channel < 0 || _chain || max_segments == 0) {
+        return false;
+    }
+    auto chain = std::make_unique<DMAChain>(_dma_channel, max_segments);
+    if(!chain->isValid()) {
+        return false;
+    }
+    _chain = std::move(chain);
+    return true;
+}
+
+bool PIODevice::isBusy() const {
+    if(_chain) {
+        return _chain->isBusy();
+    }
+    return (_dma_channel >= 0 && dma_channel_is_busy(_dma_channel)) || _fifoData != nullptr;
+}
+
 bool PIODevice::useDMA32(uint transfer_count) {
     return useDMA(transfer_count, DMA_SIZE_32);
 }
@@ -74,34 +102,227 @@ bool PIODevice::useDMA8(uint transfer_count) {
     return useDMA(transfer_count, DMA_SIZE_8);
 }
 
+bool PIODevice::useFifoIRQ() {
+    if(_dma_channel >= 0 || _fifoIRQ) {
+        return false;
+    }
+    static bool irqInstalled[2] = {false, false};
+    if(!irqInstalled[_number]) {
+        uint irq = pio_get_irq_num(_pio, 0);
+        irq_add_shared_handler(irq, pioIRQ, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(irq, true);
+        irqInstalled[_number] = true;
+    }
+    _fifoDevices[_number][_sm] = this;
+    _fifoIRQ = true;
+    return true;
+}
+
+bool PIODevice::setTransferDoneCallback(TransferDoneFunction callback) {
+    if(_fifoIRQ) {
+        _transferDone = std::move(callback);
+        return true;
+    }
+    if(_dma_channel < 0) {
+        return false;
+    }
+    static bool irqInstalled = false;
+    if(!irqInstalled) {
+        irq_add_shared_handler(DMA_IRQ_0, dmaIRQ, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        irqInstalled = true;
+    }
+    dma_channel_set_irq0_enabled(_dma_channel, false);
+    _transferDone = std::move(callback);
+    _dmaDevices[_dma_channel] = this;
+    dma_channel_set_irq0_enabled(_dma_channel, static_cast<bool>(_transferDone));
+    return true;
+}
+
+void PIODevice::dmaIRQ() {
+    Trace::recordIrq();
+    // other users of DMA_IRQ_0 acknowledge their own channels
+    for(uint32_t pending = dma_hw->ints0; pending != 0; pending &= pending - 1) {
+        int channel = __builtin_ctz(pending);
+        PIODevice *device = _dmaDevices[channel];
+        if(device == nullptr || !device->_transferDone) {
+            continue;
+        }
+        dma_hw->ints0 = 1u << channel;
+        Trace::record(Trace::Type::DmaComplete, channel);
+        device->_transferDone();
+    }
+}
+
+// The source stays enabled until the data is in the FIFO, the interrupt is
+// raised again whenever the state machine took a word
+void PIODevice::pioIRQ() {
+    Trace::recordIrq();
+    for(auto &devices : _fifoDevices) {
+        for(PIODevice *device : devices) {
+            if(device != nullptr && device->_fifoData != nullptr) {
+                device->feedFifo();
+            }
+        }
+    }
+}
+
+void PIODevice::feedFifo() {
+    const uint8_t *data = _fifoData;
+    size_t remaining = _fifoRemaining;
+    while(remaining > 0 && !pio_sm_is_tx_fifo_full(_pio, _sm)) {
+        if(_fifoBytes) {
+            pio_sm_put(_pio, _sm, static_cast<uint32_t>(*data) << 24);
+            data++;
+        }else{
+            pio_sm_put(_pio, _sm, *reinterpret_cast<const uint32_t *>(data));
+            data += sizeof(uint32_t);
+        }
+        remaining--;
+    }
+    _fifoRemaining = remaining;
+    if(remaining != 0) {
+        _fifoData = data;
+        return;
+    }
+    pio_set_irq0_source_enabled(_pio, txNotFullSource(_sm), false);
+    _fifoData = nullptr;
+    if(_transferDone) {
+        _transferDone();
+    }
+}
+
+bool PIODevice::startFifoTransfer(const void *data, size_t count, bool bytes) {
+    if(_fifoData != nullptr) {
+        return false; // the previous transfer is still fed
+    }
+    if(count == 0) {
+        return true;
+    }
+    _fifoBytes = bytes;
+    _fifoRemaining = count;
+    _fifoData = static_cast<const uint8_t *>(data);
+    // raised right away, the FIFO is not full
+    pio_set_irq0_source_enabled(_pio, txNotFullSource(_sm), true);
+    return true;
+}
+
 bool PIODevice::transfer(const uint32_t *data, size_t count) {
     if(_status != DeviceStatus::Assigned) {
         return false;
     }
 
+    if(_fifoIRQ) {
+        return startFifoTransfer(data, count, false);
+    }
     if((_dma_channel < 0) || (count != _transfer_count)) {
         for (size_t i = 0; i < count; ++i) {
             pio_sm_put_blocking(_pio, _sm, data[i]);
         }
     }else{
+        if(_chain) {
+            DMAChain::Segment segment{_transfer_count, data};
+            return transfer(&segment, 1);
+        }
         if(dma_channel_is_busy(_dma_channel)) {
             return false; // DMA is busy
         }
         // Start the DMA transfer
+        Trace::record(Trace::Type::DmaStart, _dma_channel);
         dma_channel_transfer_from_buffer_now(_dma_channel, data, _transfer_count);
     }
     return true;
 }
 
+bool PIODevice::transfer(const uint8_t *data, size_t count) {
+    if(_status != DeviceStatus::Assigned) {
+        return false;
+    }
+
+    if(_fifoIRQ) {
+        return startFifoTransfer(data, count, true);
+    }
+    if((_dma_channel < 0) || (count != _transfer_count)) {
+        for (size_t i = 0; i < count; ++i) {
+            pio_sm_put_blocking(_pio, _sm, static_cast<uint32_t>(data[i]) << 24);
+        }
+    }else{
+        if(_chain) {
+            DMAChain::Segment segment{_transfer_count, data};
+            return transfer(&segment, 1);
+        }
+        if(dma_channel_is_busy(_dma_channel)) {
+            return false; // DMA is busy
+        }
+        Trace::record(Trace::Type::DmaStart, _dma_channel);
+        dma_channel_transfer_from_buffer_now(_dma_channel, data, _transfer_count);
+    }
+    return true;
+}
+
+uint32_t PIODevice::prepareTransfer(const void *data, size_t count) {
+    if(_status != DeviceStatus::Assigned || _dma_channel < 0 || count != _transfer_count) {
+        return 0;
+    }
+    if(_chain) {
+        // started through the control channel
+        DMAChain::Segment segment{_transfer_count, data};
+        if(_chain->isBusy() || !_chain->set(&segment, 1)) {
+            return 0;
+        }
+        return _chain->prepare();
+    }
+    if(dma_channel_is_busy(_dma_channel)) {
+        return 0;
+    }
+    Trace::record(Trace::Type::DmaStart, _dma_channel);
+    dma_channel_set_read_addr(_dma_channel, data, false);
+    dma_channel_set_trans_count(_dma_channel, _transfer_count, false);
+    return 1u << _dma_channel;
+}
+
+bool PIODevice::transfer(const DMAChain::Segment *segments, size_t count) {
+    if(_status != DeviceStatus::Assigned) {
+        return false;
+    }
+    if(_chain) {
+        // the list is read while it is sent
+        return !_chain->isBusy() && _chain->set(segments, count) && _chain->start();
+    }
+    if(_fifoIRQ) {
+        return false; // fed one buffer at a time
+    }
+    for(size_t s = 0; s < count; ++s) {
+        if(_transfer_size == DMA_SIZE_8) {
+            const uint8_t *bytes = static_cast<const uint8_t *>(segments[s].data);
+            for(uint32_t i = 0; i < segments[s].count; ++i) {
+                pio_sm_put_blocking(_pio, _sm, static_cast<uint32_t>(bytes[i]) << 24);
+            }
+        } else {
+            const uint32_t *words = static_cast<const uint32_t *>(segments[s].data);
+            for(uint32_t i = 0; i < segments[s].count; ++i) {
+                pio_sm_put_blocking(_pio, _sm, words[i]);
+            }
+        }
+    }
+    return true;
+}
+
 const std::string PIODevice::getDetails() const {
     static std::string details;
     details = "PIO" + std::to_string(_number) + ".SM" + std::to_string(_sm) + "\n";
     details += "Program Offset: " + std::to_string(_program_offset) + "\n";
-    if(_dma_channel < 0) {
+    if(_fifoIRQ) {
+        details += "Fed from the FIFO interrupt\n";
+    } else if(_dma_channel < 0) {
         details += "DMA not used\n";
     } else {
         details += "DMA (CH " + std::to_string(_dma_channel);
         details += ") transfer size: " + std::to_string(_transfer_count) + "\n";
+        if(_chain) {
+            details += "Chained by DMA CH " + std::to_string(_chain->getControlChannel());
+            details += ", up to " + std::to_string(_chain->getMaxSegments()) + " segments\n";
+        }
     }
     return details;
 }
\ No newline at end of file
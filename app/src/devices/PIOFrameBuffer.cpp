@@ -0,0 +1,182 @@
+#include "devices/PIOFrameBuffer.h"
+
+#include "hardware/timer.h"
+#include "pico/stdlib.h"
+
+alarm_pool_t* PIOFrameBuffer::_latchPool = nullptr;
+uint PIOFrameBuffer::_reservedAlarms = 0;
+
+PIOFrameBuffer::PIOFrameBuffer(std::shared_ptr<PIODevice> pio, size_t count, size_t transfer_bytes, uint32_t latch_us)
+    : _pio(pio), _count(count), _transferBytes(transfer_bytes), _latchUs(latch_us) {
+  for (auto& frame : _frames) {
+    frame.assign((_count * _transferBytes + 3) / 4, 0);
+  }
+  critical_section_init(&_lock);
+  _reserved = reserveAlarm();
+  if (!_reserved) {
+    return;
+  }
+  if (_pio->isAsync()) {
+    _pio->setTransferDoneCallback([this]() { transferDone(); });
+  }
+}
+
+PIOFrameBuffer::~PIOFrameBuffer() {
+  _pio->setTransferDoneCallback(nullptr);
+  while (_waiting) {
+    tight_loop_contents(); // the alarm callback uses this object
+  }
+  critical_section_deinit(&_lock);
+  if (_reserved) {
+    _reservedAlarms--;
+  }
+}
+
+// The devices are created in thread context of core 0, the pool is created
+// with the first buffer and its interrupt runs there
+bool PIOFrameBuffer::reserveAlarm() {
+  if (_reservedAlarms >= MAX_BUFFERS) {
+    return false;
+  }
+  if (_latchPool == nullptr) {
+    int alarm = hardware_alarm_claim_unused(false);
+    if (alarm < 0) {
+      return false;
+    }
+    _latchPool = alarm_pool_create(alarm, MAX_BUFFERS);
+  }
+  _reservedAlarms++;
+  return true;
+}
+
+uint8_t* PIOFrameBuffer::getBackBuffer() {
+  critical_section_enter_blocking(&_lock);
+  _rendering = true;
+  uint8_t* back = reinterpret_cast<uint8_t*>(_frames[_front ^ 1].data());
+  critical_section_exit(&_lock);
+  return back;
+}
+
+bool PIOFrameBuffer::present() {
+  critical_section_enter_blocking(&_lock);
+  bool replaced = _pending;
+  _rendering = false;
+  _pending = true;
+  critical_section_exit(&_lock);
+  startPendingFrame();
+  return replaced;
+}
+
+// Runs in thread context, in the DMA interrupt and in the alarm interrupt.
+// The decision is made under the lock, the transfer and the alarm are started
+// outside of it (an alarm in the past runs its callback immediately).
+void PIOFrameBuffer::startPendingFrame() {
+  bool start = false;
+  int64_t wait = 0;
+  critical_section_enter_blocking(&_lock);
+  if (_pending && !_rendering && !_sending && !_waiting) {
+    wait = static_cast<int64_t>(_readyAt - time_us_64());
+    if (wait > 0) {
+      _waiting = true;
+    } else if (!_grouped) {
+      _front ^= 1;
+      _pending = false;
+      _sending = true;
+      start = true;
+    }
+  }
+  bool ready = _grouped && !start && wait <= 0 && isReady();
+  critical_section_exit(&_lock);
+
+  if (wait > 0) {
+    // cannot run out of alarms, one is reserved for this buffer
+    alarm_pool_add_alarm_in_us(_latchPool, wait, latchDone, this, true);
+  } else if (start) {
+    send();
+  } else if (ready && _groupReady) {
+    _groupReady();
+  }
+}
+
+void PIOFrameBuffer::send() {
+  transfer(_frames[_front].data());
+}
+
+bool PIOFrameBuffer::sendDirect(const void* data) {
+  if (!claimDirect()) {
+    return false;
+  }
+  transfer(data);
+  return true;
+}
+
+bool PIOFrameBuffer::sendDirect(const DMAChain::Segment* segments, size_t count) {
+  if (!claimDirect()) {
+    return false;
+  }
+  if (!_pio->transfer(segments, count) || !_pio->isAsync()) {
+    transferDone();
+  }
+  return true;
+}
+
+// Takes the PIO for a frame that is not in the buffers
+bool PIOFrameBuffer::claimDirect() {
+  critical_section_enter_blocking(&_lock);
+  bool start = !_grouped && !_pending && !_rendering && !_sending && !_waiting && time_us_64() >= _readyAt;
+  if (start) {
+    _sending = true;
+  }
+  critical_section_exit(&_lock);
+  return start;
+}
+
+void PIOFrameBuffer::transfer(const void* data) {
+  // without DMA or the FIFO interrupt the data is written to the FIFO directly
+  bool started = _transferBytes == 1 ? _pio->transfer(static_cast<const uint8_t*>(data), _count)
+                                     : _pio->transfer(static_cast<const uint32_t*>(data), _count);
+  if (!started || !_pio->isAsync()) {
+    transferDone();
+  }
+}
+
+void PIOFrameBuffer::transferDone() {
+  critical_section_enter_blocking(&_lock);
+  _sending = false;
+  _readyAt = time_us_64() + _latchUs;
+  critical_section_exit(&_lock);
+  if (_grouped && _groupDone) {
+    _groupDone();
+  }
+  startPendingFrame();
+}
+
+void PIOFrameBuffer::setGroup(GroupFunction ready, GroupFunction done) {
+  critical_section_enter_blocking(&_lock);
+  _grouped = static_cast<bool>(ready);
+  _groupReady = std::move(ready);
+  _groupDone = std::move(done);
+  critical_section_exit(&_lock);
+  // a frame queued while the group changed
+  startPendingFrame();
+}
+
+bool PIOFrameBuffer::isReady() const {
+  return _pending && !_rendering && !_sending && !_waiting && time_us_64() >= _readyAt;
+}
+
+uint32_t PIOFrameBuffer::arm() {
+  critical_section_enter_blocking(&_lock);
+  _front ^= 1;
+  _pending = false;
+  _sending = true;
+  critical_section_exit(&_lock);
+  return _pio->prepareTransfer(_frames[_front].data(), _count);
+}
+
+int64_t PIOFrameBuffer::latchDone(alarm_id_t id, void* user_data) {
+  PIOFrameBuffer* frames = static_cast<PIOFrameBuffer*>(user_data);
+  frames->_waiting = false;
+  frames->startPendingFrame();
+  return 0;
+}
@@ -2,6 +2,7 @@
 
 #include "hardware/clocks.h"
 #include "hardware/gpio.h"
+#include "Utils/Trace.h"
 
 #include <cmath>
 #include <iostream>
@@ -162,6 +163,7 @@ bool PWMDevice::transfer(const uint16_t* data, size_t count) {
         return false;
     }
 
+    Trace::record(Trace::Type::DmaStart, _dma_channel);
     dma_channel_transfer_from_buffer_now(_dma_channel, data, count);
     return true;
 }
@@ -0,0 +1,91 @@
+#include "devices/PacedPlayback.h"
+#include "LED/PackedPixel.h"
+
+#include "pico/stdlib.h"
+
+PacedPlayback::PacedPlayback(std::shared_ptr<WS2812> strip, const void* pattern, size_t pixels, bool packed,
+                             int offsetJump, uint32_t periodUs, bool loop)
+    : _strip(strip), _pattern(static_cast<const uint8_t*>(pattern)), _pixels(pixels), _packed(packed),
+      _pixelBytes(packed ? PackedPixel::BYTES : sizeof(uint32_t)), _pixelTransfers(packed ? PackedPixel::BYTES : 1),
+      _offsetJump(offsetJump),
+      _periodUs(periodUs > 0 ? periodUs : 1), _loop(loop) {}
+
+PacedPlayback::~PacedPlayback() {
+  stop();
+}
+
+bool PacedPlayback::start() {
+  if (_playing || _pixels < _strip->getLEDCount() || !_strip->canSendDirect(_pattern, _packed)) {
+    return false;
+  }
+  _offset = 0;
+  // a looped frame that runs over the end of the pattern continues at its start
+  _wrap = _loop && _offsetJump > 0 && _strip->useSegments(2);
+  _playing = true;
+  _alarm = add_alarm_in_us(START_DELAY_US, alarmCallback, this, true);
+  if (_alarm < 0) {
+    _playing = false;
+    return false;
+  }
+  return true;
+}
+
+void PacedPlayback::stop() {
+  _playing = false;
+  if (_alarm >= 0) {
+    cancel_alarm(_alarm);
+    _alarm = -1;
+  }
+  while (_inCallback) {
+    tight_loop_contents(); // the alarm of the other core uses this object
+  }
+}
+
+// Sends the frame at _offset and advances, false after the last frame
+bool PacedPlayback::nextFrame() {
+  if (!_strip->canSendDirect(_pattern, _packed)) {
+    return false;
+  }
+  const size_t leds = _strip->getLEDCount();
+  if (_offset + leds > _pixels) {
+    // only with _wrap
+    const size_t tail = _pixels - _offset;
+    const DMAChain::Segment segments[2] = {
+        {static_cast<uint32_t>(tail * _pixelTransfers), _pattern + _offset * _pixelBytes},
+        {static_cast<uint32_t>((leds - tail) * _pixelTransfers), _pattern}};
+    _strip->sendDirect(segments, 2);
+  } else {
+    _strip->sendDirect(_pattern + _offset * _pixelBytes);
+  }
+  if (_offsetJump == 0 && !_loop) {
+    // the pattern does not move, the frame just sent is the last one
+    return false;
+  }
+  _offset += _offsetJump;
+  if (_wrap) {
+    while (_offset >= _pixels) {
+      _offset -= _pixels;
+    }
+    return true;
+  }
+  if (_offset > _pixels || _pixels - _offset < leds) {
+    if (!_loop) {
+      return false;
+    }
+    _offset = 0;
+  }
+  return true;
+}
+
+int64_t PacedPlayback::alarmCallback(alarm_id_t id, void* user_data) {
+  PacedPlayback* playback = static_cast<PacedPlayback*>(user_data);
+  playback->_inCallback = true;
+  bool next = playback->_playing && playback->nextFrame();
+  if (!next) {
+    playback->_playing = false;
+    playback->_alarm = -1;
+  }
+  playback->_inCallback = false;
+  // negative: relative to the time the alarm was due, not to now
+  return next ? -static_cast<int64_t>(playback->_periodUs) : 0;
+}
@@ -10,10 +10,28 @@ Passthrough::Passthrough(std::shared_ptr<ICommDevice> commDeviceA, std::shared_p
     return;
   }
 
-  _commDeviceA->registerDataReceivedCallback([this](TaskPID) { return SignalTask(); });
-  _commDeviceB->registerDataReceivedCallback([this](TaskPID) { return SignalTask(); });
+  std::shared_ptr<ICommDevice> devices[] = {_commDeviceA, _commDeviceB};
+  for(size_t i = 0; i < 2; i++) {
+    if(!devices[i]->registerDataReceivedCallback([this](TaskPID) { return SignalTask(); })) {
+      std::cerr << "Could not register the data callback of " << devices[i]->getName() << " for Passthrough device: " << name << std::endl;
+      for(size_t j = 0; j < i; j++) {
+        devices[j]->unregisterDataReceivedCallback();
+      }
+      _status = DeviceStatus::Error;
+      return;
+    }
+  }
 
-  Mainloop::getInstance().registerRegularTask(getName() + ".Worker", [this](TaskPID) { return ExecuteTask(); });
+  TaskPID worker = Mainloop::getInstance().registerRegularTask(getName() + ".Worker", [this](TaskPID) { return ExecuteTask(); });
+  if(worker == Mainloop::INVALID_PID) {
+    std::cerr << "No free task for the worker of Passthrough device: " << name << std::endl;
+    for(auto& device : devices) {
+      device->unregisterDataReceivedCallback();
+    }
+    _status = DeviceStatus::Error;
+    return;
+  }
+  Mainloop::getInstance().setTaskPriority(worker, Mainloop::Priority::High);
     
   _status = DeviceStatus::Initialized;
 }
@@ -63,6 +81,9 @@ bool Passthrough::ExecuteTask() {
       _fifoBtoA.remove(writtenBytes);
     }
   }
+  if(_fifoAtoB.count() == 0 && _fifoBtoA.count() == 0) {
+    Mainloop::getInstance().reportIdle();
+  }
   return true;
 }
 
@@ -10,13 +10,31 @@ PassthroughMonitor::PassthroughMonitor(std::shared_ptr<ICommDevice> commDeviceA,
     return;
   }
 
-  _commDeviceA->registerDataReceivedCallback([this](TaskPID) { return SignalTask(); });
-  _commDeviceB->registerDataReceivedCallback([this](TaskPID) { return SignalTask(); });
+  std::shared_ptr<ICommDevice> devices[] = {_commDeviceA, _commDeviceB};
+  for(size_t i = 0; i < 2; i++) {
+    if(!devices[i]->registerDataReceivedCallback([this](TaskPID) { return SignalTask(); })) {
+      std::cerr << "Could not register the data callback of " << devices[i]->getName() << " for PassthroughMonitor device: " << name << std::endl;
+      for(size_t j = 0; j < i; j++) {
+        devices[j]->unregisterDataReceivedCallback();
+      }
+      _status = DeviceStatus::Error;
+      return;
+    }
+  }
 
   _monitorA = std::make_shared<MonitorDevice>(*this, commDeviceA, name + "." + commDeviceA->getName(), 0, buffersize);
   _monitorB = std::make_shared<MonitorDevice>(*this, commDeviceB, name + "." + commDeviceB->getName(), 1, buffersize);
 
-  Mainloop::getInstance().registerRegularTask(getName() + ".Worker", [this](TaskPID) { return ExecuteTask(); });
+  TaskPID worker = Mainloop::getInstance().registerRegularTask(getName() + ".Worker", [this](TaskPID) { return ExecuteTask(); });
+  if(worker == Mainloop::INVALID_PID) {
+    std::cerr << "No free task for the worker of PassthroughMonitor device: " << name << std::endl;
+    for(auto& device : devices) {
+      device->unregisterDataReceivedCallback();
+    }
+    _status = DeviceStatus::Error;
+    return;
+  }
+  Mainloop::getInstance().setTaskPriority(worker, Mainloop::Priority::High);
 
   _status = DeviceStatus::Initialized;
 }
@@ -71,18 +89,31 @@ void PassthroughMonitor::MonitorDevice::receivedData(const uint8_t* data, size_t
   }
 }
 
-bool PassthroughMonitor::MonitorDevice::registerDataReceivedCallback(Mainloop::Function func, Signal signal)  {
+bool PassthroughMonitor::MonitorDevice::registerDataReceivedCallback(Mainloop::Function func, Signal signal) {
   if(_irq_signal != 0) {
     return false;
   }
   if(signal == 0) {
     signal = 0x6D6F6E30 + _number;
   }
+  _callbackTask = Mainloop::getInstance().registerSignalTask(getName() + ".DataReceived", func, signal);
+  if(_callbackTask == Mainloop::INVALID_PID) {
+    std::cerr << "No free signal task for " << getName() << ".DataReceived" << std::endl;
+    return false;
+  }
   _irq_signal = signal;
-  Mainloop::getInstance().registerSignalTask(getName() + ".DataReceived", func, _irq_signal);
   return true;
 }
 
+void PassthroughMonitor::MonitorDevice::unregisterDataReceivedCallback() {
+  if(_irq_signal == 0) {
+    return;
+  }
+  _irq_signal = 0;
+  Mainloop::getInstance().killTask(_callbackTask);
+  _callbackTask = Mainloop::INVALID_PID;
+}
+
 bool PassthroughMonitor::ExecuteTask() {
   uint8_t buffer[_junkSize];
   if(_fifoAtoB.count() > 0) {
@@ -99,6 +130,9 @@ bool PassthroughMonitor::ExecuteTask() {
       _fifoBtoA.remove(writtenBytes);
     }
   }
+  if(_fifoAtoB.count() == 0 && _fifoBtoA.count() == 0) {
+    Mainloop::getInstance().reportIdle();
+  }
   return true;
 }
 
@@ -1,6 +1,7 @@
 #include "devices/UARTDevice.h"
 #include "hardware/irq.h"
 #include "hardware/uart.h"
+#include "Utils/Trace.h"
 #include "hardware/gpio.h"
 #include <iostream>
 
@@ -100,16 +101,30 @@ bool UARTDevice::registerDataReceivedCallback(Mainloop::Function func, Signal si
     if(signal == 0) {
         signal = 0x41525430 + _uart_number;
     }
+    _callbackTask = Mainloop::getInstance().registerSignalTask(getName() + ".DataReceived", func, signal);
+    if(_callbackTask == Mainloop::INVALID_PID) {
+        std::cerr << "No free signal task for " << getName() << ".DataReceived" << std::endl;
+        return false;
+    }
     _irq_signal = signal;
-    Mainloop::getInstance().registerSignalTask(getName() + ".DataReceived", func, _irq_signal);
     return true;
 }
 
+void UARTDevice::unregisterDataReceivedCallback() {
+    if(_irq_signal == 0) {
+        return;
+    }
+    _irq_signal = 0;
+    Mainloop::getInstance().killTask(_callbackTask);
+    _callbackTask = Mainloop::INVALID_PID;
+}
+
 const std::string UARTDevice::getDetails() const {
     return "UART Device " + std::to_string(_uart_number) + " (TX: " + std::to_string(_tx_pin) + ", RX: " + std::to_string(_rx_pin) + ", Baud: " + std::to_string(_baud_rate) + ")";
 }
 
 void UARTDevice::handleIRQ() {
+    Trace::recordIrq();
     if(uart_is_readable(_uart) != 0) {
         while(uart_is_readable(_uart) != 0 && !_rx_fifo.isFull()) {
             _rx_fifo.push(uart_getc(_uart));
@@ -1,10 +1,17 @@
 #include "devices/USBUARTDevice.h"
 #include "Utils/ValueConverter.h"
 #include "tusb.h"
+#include <iostream>
 
 
 USBUARTDevice::USBUARTDevice(int interface_number) : _interface_number(interface_number) {
-    Mainloop::getInstance().registerRegularTask(getName() + ".Worker", [this](TaskPID) { return ExecuteTask(); });
+    TaskPID worker = Mainloop::getInstance().registerRegularTask(getName() + ".Worker", [this](TaskPID) { return ExecuteTask(); });
+    if(worker == Mainloop::INVALID_PID) {
+        std::cerr << "No free task for the worker of USBUART device " << interface_number << std::endl;
+        _status = DeviceStatus::Error;
+        return;
+    }
+    Mainloop::getInstance().setTaskPriority(worker, Mainloop::Priority::High);
     _status = DeviceStatus::Initialized;
 }
 
@@ -14,6 +21,10 @@ bool USBUARTDevice::ExecuteTask() {
     if (_irq_signal != 0 && tud_cdc_n_available(_interface_number) != 0) {
         Mainloop::getInstance().triggerSignal(_irq_signal);
     }
+    // the USB interrupt wakes the core when new events arrive
+    if (!tud_task_event_ready()) {
+        Mainloop::getInstance().reportIdle();
+    }
     return true;
 }
 
@@ -45,9 +56,21 @@ bool USBUARTDevice::registerDataReceivedCallback(Mainloop::Function func, Signal
     if(signal == 0) {
         signal = 0x55534255;
     }
+    _callbackTask = Mainloop::getInstance().registerSignalTask(getName() + ".DataReceived", func, signal);
+    if(_callbackTask == Mainloop::INVALID_PID) {
+        std::cerr << "No free signal task for " << getName() << ".DataReceived" << std::endl;
+        return false;
+    }
     _irq_signal = signal;
-    Mainloop::getInstance().registerSignalTask(getName() + ".DataReceived", func, _irq_signal);
-
     return true;
 }
 
+void USBUARTDevice::unregisterDataReceivedCallback() {
+    if(_irq_signal == 0) {
+        return;
+    }
+    _irq_signal = 0;
+    Mainloop::getInstance().killTask(_callbackTask);
+    _callbackTask = Mainloop::INVALID_PID;
+}
+
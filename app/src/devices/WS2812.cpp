@@ -6,6 +6,7 @@
 #include "hardware/pio.h"
 
 #include "PIO/led.pio.h"
+#include "Mainloop.h"
 #include <cstring>
 #include <iostream>
 #include <vector>
@@ -32,27 +33,186 @@ WS2812::WS2812(std::shared_ptr<PIODevice> pio, uint pin, uint num_leds, uint bit
     return;
   }
   _program_offset_pio[_pio->getPIONumber()] = offset;
+  // packed frames are sent byte by byte, the state machine pulls every 8 bits
+  size_t transfer_bytes = isPacked() ? 1 : sizeof(uint32_t);
+  size_t transfer_count = isPacked() ? _num_leds * PackedPixel::BYTES : _num_leds;
+  uint entry_bits = isPacked() ? 8 : _bits_per_pixel;
   if (_num_leds > DMA_THRESHOLD) {
-    if(!_pio->useDMA32(_num_leds)) {
+    bool dma = isPacked() ? _pio->useDMA8(transfer_count) : _pio->useDMA32(transfer_count);
+    if(!dma) {
+      _status = DeviceStatus::Error;
+      return;
+    }
+  } else {
+    // fed from the FIFO interrupt, setPattern() does not wait for the strip
+    if(!_pio->useFifoIRQ()) {
       _status = DeviceStatus::Error;
       return;
     }
   }
 
-  led_program_init(_pio->getPIO(), _pio->getSM(), offset, _pin, freq, _bits_per_pixel);
+  led_program_init(_pio->getPIO(), _pio->getSM(), offset, _pin, freq, entry_bits);
+
+  uint32_t latch_us = static_cast<uint32_t>(FIFO_ENTRIES * entry_bits * 1000000.0f / freq) + RESET_US;
+  _frames = std::make_unique<PIOFrameBuffer>(_pio, transfer_count, transfer_bytes, latch_us);
+  if (!_frames->isValid()) {
+    _frames.reset();
+    _status = DeviceStatus::Error;
+    return;
+  }
+  _governor = FrameGovernor(static_cast<uint32_t>(_num_leds * _bits_per_pixel * 1000000.0f / freq) + RESET_US);
 
   _status = DeviceStatus::Initialized;
 }
 
+WS2812::~WS2812() {
+  stopDither();
+}
+
 const std::string WS2812::getDetails() const {
   return "WS2812 LED strip on pin " + std::to_string(_pin) + 
          " with " + std::to_string(_num_leds) + " LEDs (" + 
-         std::to_string(_bits_per_pixel) + " bits/pixel)";
+         std::to_string(_bits_per_pixel) + " bits/pixel, max " +
+         std::to_string(_governor.getMaxFrameRate()) + " frames/s)";
+}
+
+LEDFrame WS2812::getBackBuffer() {
+  if (_dither) {
+    _dither->update();
+    return LEDFrame(*_dither, _lut);
+  }
+  return LEDFrame(_frames->getBackBuffer(), _num_leds, isPacked(), _lut);
 }
 
 bool WS2812::setPattern(const uint32_t* data, size_t count) {
-  if (count < _num_leds) {
+  if (count < _num_leds || !_frames) {
     return false; 
   }
-  return _pio->transfer(data, _num_leds);
+  if (!_dither && !isPacked()) {
+    _lut.apply(data, reinterpret_cast<uint32_t*>(_frames->getBackBuffer()), _num_leds);
+  } else {
+    // packed (or into the 16 bit frame) and mapped by the LUT while copying
+    LEDFrame frame = getBackBuffer();
+    for (size_t i = 0; i < _num_leds; i++) {
+      frame.set(i, data[i]);
+    }
+  }
+  return present();
+}
+
+bool WS2812::setPackedPattern(const uint8_t* data, size_t count) {
+  if (count < _num_leds || !_frames) {
+    return false;
+  }
+  if (!_dither && isPacked() && _lut.isIdentity()) {
+    memcpy(_frames->getBackBuffer(), data, _num_leds * PackedPixel::BYTES);
+  } else {
+    LEDFrame frame = getBackBuffer();
+    for (size_t i = 0; i < _num_leds; i++, data += PackedPixel::BYTES) {
+      frame.set(i, PackedPixel::load(data));
+    }
+  }
+  return present();
+}
+
+bool WS2812::present() {
+  if (!_frames) {
+    return false;
+  }
+  if (_dither) {
+    return true; // picked up by the next refreshDither()
+  }
+  // returns the buffer that was rendered
+  _power.limit(_frames->getBackBuffer(), getFrameBytes(), _num_leds);
+  _governor.presented(_frames->present());
+  return true;
+}
+
+bool WS2812::canSendDirect(const void* data, bool packed) const {
+  if (!_frames || _dither || _frames->isGrouped() || !_lut.isIdentity() || _power.isEnabled() || packed != isPacked()) {
+    return false;
+  }
+  // the DMA reads words
+  return packed || reinterpret_cast<uintptr_t>(data) % sizeof(uint32_t) == 0;
+}
+
+// From the alarm interrupt of PacedPlayback
+bool WS2812::sendDirect(const void* data) {
+  bool sent = _frames->sendDirect(data);
+  _governor.presented(!sent);
+  return sent;
+}
+
+bool WS2812::useSegments(size_t max_segments) {
+  if (!_frames || !_pio->usesDMA()) {
+    return false;
+  }
+  return _pio->usesDMAChain() || _pio->useDMAChain(max_segments);
+}
+
+bool WS2812::sendDirect(const DMAChain::Segment* segments, size_t count) {
+  bool sent = _frames->sendDirect(segments, count);
+  _governor.presented(!sent);
+  return sent;
+}
+
+bool WS2812::setDithering(bool enabled) {
+  if (!_frames) {
+    return false;
+  }
+  if (enabled == isDithering()) {
+    return true;
+  }
+  Mainloop& mainloop = Mainloop::getInstance();
+  if (!enabled) {
+    stopDither();
+    return true;
+  }
+  // takes effect with the next frame that is set, the 16 bit frame starts dark
+  _dither = std::make_unique<TemporalDither>(_num_leds, _bits_per_pixel / 8, _lut);
+  auto state = std::make_shared<DitherTaskState>();
+  state->strip = this;
+  _ditherTask = mainloop.registerRegularTask(_name + ".Dither", [state](TaskPID) {
+    state->running = true;
+    if (!state->stopped) {
+      state->strip->refreshDither();
+    }
+    state->running = false;
+    return true;
+  });
+  if (_ditherTask == Mainloop::INVALID_PID) {
+    _dither.reset();
+    return false;
+  }
+  _ditherState = std::move(state);
+  // deferred when the iteration is out of time, the strip keeps the last frame
+  mainloop.setTaskPriority(_ditherTask, Mainloop::Priority::Low);
+  return true;
+}
+
+void WS2812::stopDither() {
+  if (!_ditherState) {
+    return;
+  }
+  _ditherState->stopped = true;
+  Mainloop::getInstance().killTask(_ditherTask);
+  while (_ditherState->running) {
+    tight_loop_contents(); // the task of the other core uses the strip
+  }
+  _ditherState.reset();
+  _ditherTask = -1;
+  _dither.reset();
+}
+
+// Queues the next dithered frame whenever the previous one was taken
+bool WS2812::refreshDither() {
+  if (!_dither || _frames->isFramePending()) {
+    Mainloop::getInstance().reportIdle();
+    return true;
+  }
+  uint8_t* back = _frames->getBackBuffer();
+  _dither->render(back, isPacked());
+  _power.limit(back, getFrameBytes(), _num_leds);
+  _frames->present();
+  return true;
 }
@@ -0,0 +1,111 @@
+#include "devices/WS2812Parallel.h"
+#include "devices/WS2812.h"
+#include "LED/BitPlane.h"
+
+#include "hardware/clocks.h"
+#include "hardware/pio.h"
+
+#include "PIO/ws2812_parallel.pio.h"
+
+int WS2812Parallel::_program_offset_pio[2][2] = {{-1, -1}, {-1, -1}};
+
+WS2812Parallel::WS2812Parallel(std::shared_ptr<PIODevice> pio, uint first_pin, uint strips, uint num_leds,
+                               uint bits_per_pixel, float freq, const std::string& name)
+    : _pio(pio), _first_pin(first_pin), _strips(strips), _bits_per_pixel(bits_per_pixel), _num_leds(num_leds),
+      _name(name) {
+
+  if (strips == 0 || strips > MAX_STRIPS || num_leds == 0 || bits_per_pixel % 8 != 0 || bits_per_pixel > 32) {
+    _status = DeviceStatus::Error;
+    return;
+  }
+
+  // The out instruction shifts one plane per bit time, 8 or 16 bits
+  size_t width = BitPlane::planeWidth(_strips);
+  int& offset = _program_offset_pio[_pio->getPIONumber()][width - 1];
+  if (offset < 0) {
+    uint16_t instructions[4];
+    pio_program_t program = ws2812_parallel_program_for_width(instructions, width * 8);
+    if (_pio->addProgram(&program)) {
+      offset = _pio->getProgramOffset();
+    }
+  } else {
+    _pio->setProgramOffset(offset);
+  }
+  if (offset < 0) {
+    _status = DeviceStatus::Error;
+    return;
+  }
+
+  size_t words = BitPlane::frameSize(_strips, _num_leds, _bits_per_pixel) / sizeof(uint32_t);
+  if (!_pio->useDMA32(words)) {
+    _status = DeviceStatus::Error;
+    return;
+  }
+
+  ws2812_parallel_program_init(_pio->getPIO(), _pio->getSM(), offset, _first_pin, _strips, freq);
+
+  // 9 FIFO words (joined TX FIFO and OSR) with 32 / (8 * width) planes each
+  uint32_t fifo_bits = 9 * 32 / (8 * width);
+  uint32_t latch_us = static_cast<uint32_t>(fifo_bits * 1000000.0f / freq) + WS2812::RESET_US;
+  _frames = std::make_unique<PIOFrameBuffer>(_pio, words, sizeof(uint32_t), latch_us);
+  if (!_frames->isValid()) {
+    _frames.reset();
+    _status = DeviceStatus::Error;
+    return;
+  }
+  // the strips are sent at the same time
+  _governor = FrameGovernor(static_cast<uint32_t>(_num_leds * _bits_per_pixel * 1000000.0f / freq) + WS2812::RESET_US);
+
+  _status = DeviceStatus::Initialized;
+}
+
+const std::string WS2812Parallel::getDetails() const {
+  return "WS2812 parallel output on pins " + std::to_string(_first_pin) + " to " +
+         std::to_string(_first_pin + _strips - 1) + ", " + std::to_string(_strips) + " strips with " +
+         std::to_string(_num_leds) + " LEDs (" + std::to_string(_bits_per_pixel) + " bits/pixel)";
+}
+
+bool WS2812Parallel::setPattern(const uint32_t* data, size_t count) {
+  if (count < getLEDCount()) {
+    return false;
+  }
+  const uint32_t* strips[MAX_STRIPS];
+  for (size_t s = 0; s < _strips; s++) {
+    strips[s] = data + s * _num_leds;
+  }
+  return setStrips(strips);
+}
+
+bool WS2812Parallel::setPackedPattern(const uint8_t* data, size_t count) {
+  if (count < getLEDCount() || !_frames || _bits_per_pixel != 24) {
+    return false;
+  }
+  const uint8_t* strips[MAX_STRIPS];
+  for (size_t s = 0; s < _strips; s++) {
+    strips[s] = data + s * _num_leds * 3;
+  }
+  uint8_t* planes = _frames->getBackBuffer();
+  if (_lut.isIdentity()) {
+    BitPlane::transposePacked(strips, _strips, _num_leds, planes);
+  } else {
+    BitPlane::transposePacked(strips, _strips, _num_leds, planes, [this](uint32_t pixel) { return _lut.map(pixel); });
+  }
+  _governor.presented(_frames->present());
+  return true;
+}
+
+bool WS2812Parallel::setStrips(const uint32_t* const* strips) {
+  if (!_frames) {
+    return false;
+  }
+  uint8_t* planes = _frames->getBackBuffer();
+  if (_lut.isIdentity()) {
+    BitPlane::transpose(strips, _strips, _num_leds, _bits_per_pixel, planes);
+  } else {
+    // the LUT is applied to the pixels as they are loaded
+    BitPlane::transpose(strips, _strips, _num_leds, _bits_per_pixel, planes,
+                        [this](uint32_t pixel) { return _lut.map(pixel); });
+  }
+  _governor.presented(_frames->present());
+  return true;
+}
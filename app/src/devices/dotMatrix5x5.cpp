@@ -1,4 +1,5 @@
 #include "devices/dotMatrix5x5.h"
+#include "Config.h"
 #include "devices/MatrixChar5x5.h"
 #include <cstring>
 #include <iostream>
@@ -7,11 +8,14 @@
 dotMatrix5x5::dotMatrix5x5(std::shared_ptr<WS2812> led, const std::string& name, const std::string& start, uint32_t color)
     : IDisplayDevice(color), _led(led), _name(name) {
 
-  setValue(start);
+  if (led->getLEDCount() < 25) {
+    _status = DeviceStatus::Error; // the frame is rendered into the buffer of the strip
+    return;
+  }
 
-  _currentFrame.resize(25, 0); // 5x5 matrix = 25 LEDs
+  updateValue(start);
 
-  _scrollingTask = Mainloop::getInstance().registerTimedTask(name + ".TextScrolling", [this](TaskPID) { return scrollText(); }, 100);
+  _scrollingTask = Mainloop::getInstance().registerTimedTask(name + ".TextScrolling", [this](TaskPID) { return scrollText(); }, 100, 0, LED_RENDER_CORE);
 
   _status = DeviceStatus::Initialized;
 }
@@ -21,6 +25,11 @@ const std::string dotMatrix5x5::getDetails() const {
 }
 
 void dotMatrix5x5::setValue(const std::string& value){
+  // the text is rendered by the scrolling task, so it is updated on the same core
+  Mainloop::getInstance(LED_RENDER_CORE).invoke([this, value]() { updateValue(value); });
+}
+
+void dotMatrix5x5::updateValue(const std::string& value){
   if (value.length() < 1) {
     std::cerr << "Invalid value length for dotMatrix5x5 display: " << value << std::endl;
     return;
@@ -71,12 +80,15 @@ bool dotMatrix5x5::scrollText() {
   int startIndex = _current_offset / 30;
   int endIndex = (_current_offset + 5) / 30;
 
+  // rendered directly into the back buffer of the strip, the frame being sent is not touched
+  LEDFrame frame = _led->getBackBuffer();
+
   if(startIndex == endIndex) {
     int bit_offset = _current_offset - startIndex * 30;
     for (int col = 0; col < 5; col++) {
       uint32_t columnData = _ledData[startIndex + col * _total_columns] >> bit_offset;
       for (int row = 0; row < 5; row++) {
-        _currentFrame[row + col * 5] = (columnData & 0x01) ? _color : 0x00000000;
+        frame.set(row + col * 5, (columnData & 0x01) ? _color : 0x00000000);
         columnData >>= 1;
       }
     }
@@ -91,12 +103,14 @@ bool dotMatrix5x5::scrollText() {
       uint32_t columnData = columnDataStart | columnDataEnd;
 
       for (int row = 0; row < 5; row++) {
-        _currentFrame[row + col * 5] = (columnData & 0x01) ? _color : 0x00000000;
+        frame.set(row + col * 5, (columnData & 0x01) ? _color : 0x00000000);
         columnData >>= 1;
       }
     }
   }
-  _led->setPattern(_currentFrame);
+  // LEDs behind the matrix are off
+  frame.fill(25, _led->getLEDCount(), 0x00000000);
+  _led->present();
 
   if(!_scrollingEnabled) {
     return true; // If scrolling is disabled, just display the static text
@@ -1,4 +1,5 @@
 #include "devices/dotMatrix8xN.h"
+#include "Config.h"
 #include "devices/MatrixChar8x8.h"
 #include <cstring>
 #include <iostream>
@@ -7,20 +8,25 @@
 dotMatrix8xN::dotMatrix8xN(std::shared_ptr<WS2812> led, const std::string& name, const std::string& start, uint32_t color)
     : IDisplayDevice(color), _led(led), _name(name) {
 
-  setValue(start);
+  updateValue(start);
 
-  _currentFrame.resize(led->getLEDCount() & ~0x07, 0);
+  _frameSize = led->getLEDCount() & ~0x07;
 
-  _scrollingTask = Mainloop::getInstance().registerTimedTask(name + ".TextScrolling", [this](TaskPID) { return scrollText(); }, 100);
+  _scrollingTask = Mainloop::getInstance().registerTimedTask(name + ".TextScrolling", [this](TaskPID) { return scrollText(); }, 100, 0, LED_RENDER_CORE);
 
   _status = DeviceStatus::Initialized;
 }
 
 const std::string dotMatrix8xN::getDetails() const {
-  return "dotMatrix8xN device with " + std::to_string(_currentFrame.size()) + " LEDs using WS2812 device: " + _led->getName();
+  return "dotMatrix8xN device with " + std::to_string(_frameSize) + " LEDs using WS2812 device: " + _led->getName();
 }
 
 void dotMatrix8xN::setValue(const std::string& value){
+  // the text is rendered by the scrolling task, so it is updated on the same core
+  Mainloop::getInstance(LED_RENDER_CORE).invoke([this, value]() { updateValue(value); });
+}
+
+void dotMatrix8xN::updateValue(const std::string& value){
   if (value.length() < 1) {
     std::cerr << "Invalid value length for dotMatrix8xN display: " << value << std::endl;
     return;
@@ -45,14 +51,16 @@ bool dotMatrix8xN::scrollText() {
     return true;
   }
 
-  if (_ledData.size() < _currentFrame.size() / 8) {
+  if (_ledData.size() < _frameSize / 8) {
     return staticText();
   }
   
+  // rendered directly into the back buffer of the strip, the frame being sent is not touched
+  LEDFrame frame = _led->getBackBuffer();
   int position = _current_offset;
   int LEDDirection = 0; // 0 = UpDown, 1 = DownUp
 
-  for (size_t i = 0; i < _currentFrame.size(); position++) {
+  for (size_t i = 0; i < _frameSize; position++) {
     if(position >= _ledData.size()) {
       position = 0;
     }
@@ -60,18 +68,20 @@ bool dotMatrix8xN::scrollText() {
     uint8_t columnData = _ledData[position];
     if(LEDDirection == 0) {
       for(int bit = 0; bit < 8; bit++, i++) {
-        _currentFrame[i] = (columnData & (1 << bit)) ? _color : 0x00000000;
+        frame.set(i, (columnData & (1 << bit)) ? _color : 0x00000000);
       }
       LEDDirection = 1;
     }else{
       for(int bit = 7; bit >= 0; bit--, i++) {
-        _currentFrame[i] = (columnData & (1 << bit)) ? _color : 0x00000000;
+        frame.set(i, (columnData & (1 << bit)) ? _color : 0x00000000);
       }
       LEDDirection = 0;
     }
   }
+  // LEDs of an incomplete column are off
+  frame.fill(_frameSize, _led->getLEDCount(), 0x00000000);
 
-  _led->setPattern(_currentFrame);
+  _led->present();
 
   switch (_scrollingDirection) {
     case ScrollingDirection::LEFT:
@@ -94,23 +104,27 @@ bool dotMatrix8xN::scrollText() {
 }
 
 bool dotMatrix8xN::staticText() {
+  LEDFrame frame = _led->getBackBuffer();
   int LEDDirection = 0; // 0 = UpDown, 1 = DownUp
+  size_t i = 0;
 
-  for (size_t i = 0, position = 0; position < _ledData.size(); position++) {
+  for (size_t position = 0; position < _ledData.size(); position++) {
     uint8_t columnData = _ledData[position];
     if(LEDDirection == 0) {
       for(int bit = 0; bit < 8; bit++, i++) {
-        _currentFrame[i] = (columnData & (1 << bit)) ? _color : 0x00000000;
+        frame.set(i, (columnData & (1 << bit)) ? _color : 0x00000000);
       }
       LEDDirection = 1;
     }else{
       for(int bit = 7; bit >= 0; bit--, i++) {
-        _currentFrame[i] = (columnData & (1 << bit)) ? _color : 0x00000000;
+        frame.set(i, (columnData & (1 << bit)) ? _color : 0x00000000);
       }
       LEDDirection = 0;
     }
   }
+  // the back buffer still holds an older frame
+  frame.fill(i, _led->getLEDCount(), 0x00000000);
 
-  _led->setPattern(_currentFrame);
+  _led->present();
   return true;
 }
\ No newline at end of file